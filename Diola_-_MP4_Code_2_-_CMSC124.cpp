@@ -42,13 +42,64 @@ Postfix Grammar:
 
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <stack>
 #include <algorithm>
 #include <cmath>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <charconv>
+#include <cstdint>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAPPED_INPUT
+#endif
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define COLUMN_KERNELS_X86
+#define CHARACTER_MASKS_X86
+#endif
 
 using namespace std;
 
+#ifdef COUNT_ALLOCATIONS
+//Built with -DCOUNT_ALLOCATIONS every heap allocation of the program is counted here, for allocation_benchmark
+atomic<long long> allocation_count(0);
+
+void* operator new(size_t size){
+	allocation_count.fetch_add(1, memory_order_relaxed);
+	void* memory = malloc(size == 0 ? 1 : size);
+	if(memory == NULL){
+		throw bad_alloc();
+	}
+	return memory;
+}
+
+void operator delete(void* memory) noexcept{
+	free(memory);
+}
+
+void operator delete(void* memory, size_t size) noexcept{
+	free(memory);
+}
+#endif
+
 
 enum ExpressionType{
 
@@ -98,15 +149,155 @@ enum TokenType{
 
 };
 
+//The token type of every byte, so classifying a character is one load instead of a chain of comparisons.
+//Bytes outside the grammar are ERROR_TOKEN.
+struct CharacterTable{
+
+	TokenType types[256];
+
+};
+
+constexpr CharacterTable make_character_table(){
+	CharacterTable table = {};
+	for(int c=0; c<256; c++){
+		table.types[c] = ERROR_TOKEN;
+	}
+	for(int c='0'; c<='9'; c++){
+		table.types[c] = DIGIT;
+	}
+	for(int c='a'; c<='z'; c++){
+		table.types[c] = LETTER;
+		table.types[c - 'a' + 'A'] = LETTER;
+	}
+	table.types['+'] = ADD_OP;
+	table.types['-'] = SUB_OP;
+	table.types['*'] = MULT_OP;
+	table.types['/'] = DIV_OP;
+	table.types['^'] = EXP_OP;
+	table.types['('] = L_PAR;
+	table.types[')'] = R_PAR;
+	table.types['_'] = UNDERSCORE;
+	table.types[' '] = SPACE;
+	table.types['\0'] = END;
+	return table;
+}
+
+constexpr CharacterTable character_table = make_character_table();
+
+inline TokenType char_token_type(char c){
+	return character_table.types[(unsigned char) c];
+}
+
+//What the parsers and the tree need to know about each token type, indexed by TokenType
+struct TokenTypeTable{
+
+	bool is_operator[END + 1];
+	bool is_operand[END + 1];
+	int priority[END + 1];
+
+};
+
+constexpr TokenTypeTable make_token_type_table(){
+	TokenTypeTable table = {};
+	table.is_operator[ADD_OP] = true;
+	table.is_operator[SUB_OP] = true;
+	table.is_operator[MULT_OP] = true;
+	table.is_operator[DIV_OP] = true;
+	table.is_operator[EXP_OP] = true;
+	table.is_operand[DIGIT] = true;
+	table.is_operand[LETTER] = true;
+	table.priority[ADD_OP] = 1;
+	table.priority[SUB_OP] = 1;
+	table.priority[MULT_OP] = 2;
+	table.priority[DIV_OP] = 2;
+	table.priority[EXP_OP] = 3;
+	return table;
+}
+
+constexpr TokenTypeTable token_type_table = make_token_type_table();
+
+struct Token{
+
+	TokenType type;
+	int offset;
+	int length;
+
+};
+
+//One node of the expression tree. Operands have no children (left and right are -1).
+struct ExpressionNode{
+
+	Token token;
+	int left;
+	int right;
+	int priority;
+
+};
+
+//An operator of an infix expression still waiting for its right operand, with the tree already built on its left.
+//An open parenthesis is a frame too: its binding power of 0 stops every fold at it.
+struct InfixFrame{
+
+	int left;
+	int op;		//index of the operator or parenthesis token
+
+};
+
+//A node waiting to be written out by the infix emitter, and how far along it is
+struct EmitFrame{
+
+	int node;
+	int stage;
+	bool parenthesized;
+
+};
+
+//Holds every node of one expression tree in a single block of memory. The block is sized once before the tree is
+//built, nodes are handed out one after the other and refer to each other by index, and the whole tree is freed at once.
+class ExpressionArena{
+
+	private:
+
+	vector<ExpressionNode> block;
+
+	public:
+
+	//Drops the old tree but keeps the memory, so a reused arena only allocates when the new tree is bigger
+	void reset(int node_count){
+		block.clear();
+		block.reserve(node_count);
+	}
+
+	int allocate(const Token &token, int left, int right, int priority){
+		ExpressionNode node;
+		node.token = token;
+		node.left = left;
+		node.right = right;
+		node.priority = priority;
+		block.push_back(node);
+		return block.size() - 1;
+	}
+
+	ExpressionNode& operator[](int index){
+		return block[index];
+	}
+
+	int size(void){
+		return block.size();
+	}
+
+};
+
 class ExpressionParser{
 
 	protected:
 
-	string input;
+	string_view input;		//the caller's text, never copied
 	char current_char;
 	TokenType token_type;
 	int iter;
 	bool valid;
+	int max_depth;			//deepest nesting accepted before the input is rejected
 
 	int next_char(void){
 		int input_length = input.length();
@@ -116,7 +307,11 @@ class ExpressionParser{
 		}
 		
 		iter++;
-		current_char = input[iter];
+		if(iter < input_length){
+			current_char = input[iter];
+		} else {
+			current_char = '\0';	//a string_view has no terminator to read
+		}
 
 		return 0;
 	}
@@ -124,7 +319,7 @@ class ExpressionParser{
 	// virtual TokenType peek(void) = 0;
 
 	void skip_whitespace() {
-		while (isspace(current_char)) 
+		while (char_token_type(current_char) == SPACE) 
 			next_char();
 	}
 
@@ -134,11 +329,20 @@ class ExpressionParser{
 
 	public:
 
-	ExpressionParser(string init_input){
+	ExpressionParser(string_view init_input){
 		input = init_input;
 		current_char = 0;
 		iter = -1;
 		valid = true;
+		max_depth = default_max_depth;
+	}
+
+	static const int default_max_depth = 1 << 24;
+
+	//The parsers keep their nesting in a counter instead of the call stack, so the limit only bounds how deep an
+	//input may go, not how much memory parsing it takes
+	void set_max_depth(int depth){
+		max_depth = depth;
 	}
 
 	virtual int parse(void){
@@ -171,46 +375,7 @@ class InfixExpressionParser : public ExpressionParser{
 	int lex(){
 		next_char();
 		// skip_whitespace();
-		if(current_char == '+'){
-			token_type = ADD_OP;
-		} 
-		else if(current_char == '-'){
-			token_type = SUB_OP;
-		}
-		else if(current_char == '*'){
-			token_type = MULT_OP;
-		}
-		else if(current_char == '/'){
-			token_type = DIV_OP;
-		}
-		else if(current_char == '^'){
-			token_type = EXP_OP;
-		}
-		else if(current_char == '('){
-			token_type = L_PAR;
-		}
-		else if(current_char == ')'){
-			token_type = R_PAR;
-		}
-		else if(current_char >= '0' && current_char <= '9'){
-			token_type = DIGIT;
-		}
-		else if(current_char == '_'){
-			token_type = UNDERSCORE;
-		}
-		else if((current_char >= 'a' && current_char <= 'z') || (current_char >= 'A' && current_char <= 'Z')){
-			token_type = LETTER;
-		} 
-		else if(current_char == '\0'){
-			token_type = END;
-		}
-		else if(current_char == ' '){
-			token_type = SPACE;
-		}
-		else {
-			token_type = ERROR_TOKEN;
-		}
-
+		token_type = char_token_type(current_char);
 
 		return 0;
 	}
@@ -222,58 +387,60 @@ class InfixExpressionParser : public ExpressionParser{
 		return 0;
 	}
 
+	//<expr> and <term> are flat loops, so the only nesting is a parenthesized <factor>. Each open parenthesis
+	//is the same frame, so the explicit stack shrinks to its height.
 	int expr(){
-		term();
-		while(token_type == ADD_OP || token_type == SUB_OP){
-			lex();
-			if(token_type == SPACE){
-				lex();
-			}
-			term();
-		}
-		return 0;
-	}
+		int depth = 0;
 
-	int term(){
-		factor();
-		while(token_type == MULT_OP || token_type == DIV_OP || token_type == EXP_OP){
-			lex();
-			if(token_type == SPACE){
+		while(true){
+			//<factor>: any opening parentheses, then a number or a letter
+			while(token_type == L_PAR){
+				if(depth == max_depth){
+					valid = false;
+					return 1;
+				}
+				depth++;
 				lex();
+				if(token_type == SPACE){
+					lex();
+				}
 			}
-			factor();
-		}
-		return 0;
-	}
-
-	int factor(){
-		if(token_type == L_PAR){
-			lex();
-			if(token_type == SPACE){
-				lex();
+			if(token_type == DIGIT){
+				number();
 			}
-			expr();
-			if(token_type != R_PAR){
+			else if(token_type == LETTER){
+				lex();
+				if(token_type == SPACE){
+					lex();
+				}
+			} else {
 				valid = false;
+				return 1;
 			}
-			lex();
-			if(token_type == SPACE){
+
+			//then closing parentheses, until an operator asks for the next <factor>
+			while(!token_type_table.is_operator[token_type]){
+				if(depth == 0){
+					return 0;
+				}
+				if(token_type != R_PAR){
+					valid = false;
+					return 1;
+				}
+				depth--;
 				lex();
+				if(token_type == SPACE){
+					lex();
+				}
 			}
-		}
-		else if(token_type == DIGIT){
-			number();
-		}
-		else if(token_type == LETTER){
 			lex();
 			if(token_type == SPACE){
 				lex();
 			}
-		} else {
-			valid = false;
 		}
 		return 0;
 	}
+
 	int number(){
 		lex();
 		while(token_type == DIGIT){
@@ -288,7 +455,7 @@ class InfixExpressionParser : public ExpressionParser{
 
 	public:
 
-	InfixExpressionParser(string expression) : ExpressionParser(expression){
+	InfixExpressionParser(string_view expression) : ExpressionParser(expression){
 
 		// cout << "Expression Received: " << expression << endl;
 	}
@@ -304,38 +471,12 @@ class PrefixExpressionParser : public ExpressionParser{
 	int lex(){
 		next_char();
 		// skip_whitespace();
-		if(current_char == '+'){
-			token_type = ADD_OP;
-		} 
-		else if(current_char == '-'){
-			token_type = SUB_OP;
-		}
-		else if(current_char == '*'){
-			token_type = MULT_OP;
-		}
-		else if(current_char == '/'){
-			token_type = DIV_OP;
-		}
-		else if(current_char == '^'){
-			token_type = EXP_OP;
-		}
-		else if(current_char >= '0' && current_char <= '9'){
-			token_type = DIGIT;
-		}
-		else if((current_char >= 'a' && current_char <= 'z') || (current_char >= 'A' && current_char <= 'Z')){
-			token_type = LETTER;
-		} 
-		else if(current_char == '\0'){
-			token_type = END;
-		}
-		else if(current_char == ' '){
-			token_type = SPACE;
-		}
-		else {
+		token_type = char_token_type(current_char);
+		//Parentheses and underscores are not part of this grammar
+		if(token_type == L_PAR || token_type == R_PAR || token_type == UNDERSCORE){
 			token_type = ERROR_TOKEN;
 		}
 
-
 		return 0;
 	}
 
@@ -346,17 +487,29 @@ class PrefixExpressionParser : public ExpressionParser{
 		return 0;
 	}
 
+	//Counts the <expr>s still owed instead of recursing into them: an operator owes two in place of the one
+	//it fills, an operand pays one. The depth is the number of operators still waiting for an operand.
 	int expr(){
-		if(token_type == ADD_OP || token_type == SUB_OP || token_type == MULT_OP || token_type == DIV_OP || token_type == EXP_OP){
-			lex();
-			if(token_type == SPACE){
+		int needed = 1;
+
+		while(needed > 0){
+			if(token_type == ADD_OP || token_type == SUB_OP || token_type == MULT_OP || token_type == DIV_OP || token_type == EXP_OP){
+				if(needed > max_depth){
+					valid = false;
+					return 1;
+				}
+				needed++;
 				lex();
+				if(token_type == SPACE){
+					lex();
+				}
+			}
+			else if(token_type == DIGIT || token_type == LETTER){
+				term();
+				needed--;
+			} else {
+				break;		//the recursive parser stopped here too, parse() judges the token left over
 			}
-			expr();
-			expr();
-		}
-		else{
-			term();
 		}
 		return 0;
 	}
@@ -390,7 +543,7 @@ class PrefixExpressionParser : public ExpressionParser{
 
 	public:
 
-	PrefixExpressionParser(string expression) : ExpressionParser(expression){
+	PrefixExpressionParser(string_view expression) : ExpressionParser(expression){
 
 		// cout << "Expression Received: " << expression << endl;
 	}
@@ -407,38 +560,12 @@ class PostfixExpressionParser : public ExpressionParser{
 	int lex(){
 		next_char();
 		// skip_whitespace();
-		if(current_char == '+'){
-			token_type = ADD_OP;
-		} 
-		else if(current_char == '-'){
-			token_type = SUB_OP;
-		}
-		else if(current_char == '*'){
-			token_type = MULT_OP;
-		}
-		else if(current_char == '/'){
-			token_type = DIV_OP;
-		}
-		else if(current_char == '^'){
-			token_type = EXP_OP;
-		}
-		else if(current_char >= '0' && current_char <= '9'){
-			token_type = DIGIT;
-		}
-		else if((current_char >= 'a' && current_char <= 'z') || (current_char >= 'A' && current_char <= 'Z')){
-			token_type = LETTER;
-		} 
-		else if(current_char == '\0'){
-			token_type = END;
-		}
-		else if(current_char == ' '){
-			token_type = SPACE;
-		}
-		else {
+		token_type = char_token_type(current_char);
+		//Parentheses and underscores are not part of this grammar
+		if(token_type == L_PAR || token_type == R_PAR || token_type == UNDERSCORE){
 			token_type = ERROR_TOKEN;
 		}
 
-
 		return 0;
 	}
 
@@ -453,30 +580,25 @@ class PostfixExpressionParser : public ExpressionParser{
 
 	int expr(){
 
-		stack<string> token_stack;
-		
-		string current_token = "";
+		//Only the height of the operand stack decides validity, so a counter stands in for the stack of token copies
+		int stack_size = 0;
 
 		while(token_type != END && token_type != ERROR_TOKEN){
 			if(token_type == DIGIT){
 				while(token_type == DIGIT){
-					current_token += current_char;
 					lex();
 				}
-				token_stack.push(current_token);
-				current_token.clear();
+				stack_size++;
 			}
 			else if(token_type == LETTER){
-				current_token += current_char;
-				token_stack.push(current_token);
+				stack_size++;
 				lex();
-				current_token.clear();
 			} else if(token_type == ADD_OP || token_type == SUB_OP || token_type == MULT_OP || token_type == DIV_OP || token_type == EXP_OP){
-				if(token_stack.size()<2){
+				if(stack_size<2){
 					valid = false;
 					return 1;
 				}
-				token_stack.pop();
+				stack_size--;
 				lex();
 			} else if(token_type == SPACE){
 				lex();
@@ -485,7 +607,7 @@ class PostfixExpressionParser : public ExpressionParser{
 				break;
 			}
 		}
-		if(token_stack.size() != 1){
+		if(stack_size != 1){
 			valid = false;
 		}
 		// term();
@@ -515,7 +637,7 @@ class PostfixExpressionParser : public ExpressionParser{
 
 	public:
 
-	PostfixExpressionParser(string expression) : ExpressionParser(expression){
+	PostfixExpressionParser(string_view expression) : ExpressionParser(expression){
 
 		// cout << "Expression Received: " << expression << endl;
 	}
@@ -523,1450 +645,6410 @@ class PostfixExpressionParser : public ExpressionParser{
 
 };
 
-class Expression{
+//One bit per input byte for each class of character: bit i % 64 of word i / 64 is byte i. Bits past the end of the
+//input are 0. Spaces are only ' '. errors holds everything else, which includes '_' and '\0'.
+struct CharacterMasks{
+
+	vector<uint64_t> operators;
+	vector<uint64_t> digits;
+	vector<uint64_t> letters;
+	vector<uint64_t> parentheses;
+	vector<uint64_t> spaces;
+	vector<uint64_t> errors;
+
+	void resize(int word_count){
+		operators.resize(word_count);
+		digits.resize(word_count);
+		letters.resize(word_count);
+		parentheses.resize(word_count);
+		spaces.resize(word_count);
+		errors.resize(word_count);
+	}
 
+};
 
-	private:
+typedef void (*MaskKernel)(const char* text, int length, CharacterMasks &masks);
 
-		string expression;
-		ExpressionType type;
+void classify_bytes_scalar(const char* text, int length, CharacterMasks &masks){
+	int word_count = (length + 63) / 64;
+	masks.resize(word_count);
 
-		bool is_valid_infix() const{
-			InfixExpressionParser parser(expression);
-			if(parser.parse() == 0){
-				return true;
-			} else{
-				return false;
+	for(int word=0; word<word_count; word++){
+		uint64_t operators = 0, digits = 0, letters = 0, parentheses = 0, spaces = 0, errors = 0;
+		int end = min(64, length - word * 64);
+		for(int k=0; k<end; k++){
+			uint64_t bit = (uint64_t) 1 << k;
+			TokenType type = char_token_type(text[word * 64 + k]);
+			if(token_type_table.is_operator[type]){
+				operators |= bit;
 			}
-		}
-
-		bool is_valid_prefix() const{
-			PrefixExpressionParser parser(expression);
-			if(parser.parse() == 0){
-				return true;
-			} else{
-				return false;
+			else if(type == DIGIT){
+				digits |= bit;
 			}
-		}
-
-		bool is_valid_postfix() const{
-			PostfixExpressionParser parser(expression);
-			if(parser.parse() == 0){
-				return true;
-			} else{
-				return false;
+			else if(type == LETTER){
+				letters |= bit;
 			}
-		}
-
-		void evaluate_type(void){
-
-			if(this->is_valid_infix()){
-				type = INFIX;
-			} 
-			else if(this->is_valid_prefix()){
-				type = PREFIX;
-			} 
-			else if(this->is_valid_postfix()){
-				type = POSTFIX;
+			else if(type == L_PAR || type == R_PAR){
+				parentheses |= bit;
 			}
-			else {
-				type = ERROR_EXPR;
+			else if(type == SPACE){
+				spaces |= bit;
+			} else {
+				errors |= bit;
 			}
-			
 		}
+		masks.operators[word] = operators;
+		masks.digits[word] = digits;
+		masks.letters[word] = letters;
+		masks.parentheses[word] = parentheses;
+		masks.spaces[word] = spaces;
+		masks.errors[word] = errors;
+	}
+}
 
-		int get_priority(char c){
-			if (c == '-' || c == '+')
-				return 1;
-			else if (c == '*' || c == '/')
-				return 2;
-			else if (c == '^')
-				return 3;
-			return 0;
+#ifdef CHARACTER_MASKS_X86
+
+//64 bytes per mask word: two 32 byte compares with AVX2 or four 16 byte ones with SSE2. The last partial word is
+//copied into a zeroed block so no load reads past the input.
+__attribute__((target("sse2")))
+void classify_bytes_sse2(const char* text, int length, CharacterMasks &masks){
+	int word_count = (length + 63) / 64;
+	masks.resize(word_count);
+
+	char padded[64];
+	for(int word=0; word<word_count; word++){
+		const char* block = text + word * 64;
+		int remaining = length - word * 64;
+		uint64_t valid = ~(uint64_t) 0;
+		if(remaining < 64){
+			memset(padded, 0, 64);
+			memcpy(padded, block, remaining);
+			block = padded;
+			valid = ((uint64_t) 1 << remaining) - 1;
 		}
 
-		int get_priority(string str){
-			if(str.compare("-")==0 || str.compare("+")==0){
-				return 1;
-			} 
-			else if(str.compare("*")==0 || str.compare("/")==0){
-				return 2;
-			} 
-			else if(str.compare("^")==0){
-				return 3;
-			}
-			return 0;
+		uint64_t operators = 0, digits = 0, letters = 0, parentheses = 0, spaces = 0;
+		for(int part=0; part<4; part++){
+			__m128i x = _mm_loadu_si128((const __m128i*) (block + part * 16));
+			//c - '0' <= 9 and (c | 0x20) - 'a' <= 25 as unsigned bytes, where min(v, limit) == v means v <= limit
+			__m128i digit_offset = _mm_sub_epi8(x, _mm_set1_epi8('0'));
+			__m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit_offset, _mm_set1_epi8(9)), digit_offset);
+			__m128i letter_offset = _mm_sub_epi8(_mm_or_si128(x, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+			__m128i is_letter = _mm_cmpeq_epi8(_mm_min_epu8(letter_offset, _mm_set1_epi8(25)), letter_offset);
+			__m128i is_operator = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('+')), _mm_cmpeq_epi8(x, _mm_set1_epi8('-'))),
+					_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('*')), _mm_cmpeq_epi8(x, _mm_set1_epi8('/'))),
+					_mm_cmpeq_epi8(x, _mm_set1_epi8('^'))));
+			__m128i is_parenthesis = _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('(')), _mm_cmpeq_epi8(x, _mm_set1_epi8(')')));
+			__m128i is_space = _mm_cmpeq_epi8(x, _mm_set1_epi8(' '));
+
+			int shift = part * 16;
+			operators |= (uint64_t) (uint32_t) _mm_movemask_epi8(is_operator) << shift;
+			digits |= (uint64_t) (uint32_t) _mm_movemask_epi8(is_digit) << shift;
+			letters |= (uint64_t) (uint32_t) _mm_movemask_epi8(is_letter) << shift;
+			parentheses |= (uint64_t) (uint32_t) _mm_movemask_epi8(is_parenthesis) << shift;
+			spaces |= (uint64_t) (uint32_t) _mm_movemask_epi8(is_space) << shift;
 		}
 
-		int get_least_priority(string expression){
-			int prio = 100;
-			int par_encountered = 0;
-			for(int i=0; i<expression.length(); i++){
-				if(is_operator(expression[i])){
-					if(get_priority(expression[i]) < prio && par_encountered <2){
-						prio = get_priority(expression[i]);
-					}
-				}
-				if(expression[i] == '('){
-					par_encountered++;
-				} else if (expression[i] == ')'){
-					par_encountered--;
-				}
-			}
-			return prio;
-		}
+		masks.operators[word] = operators & valid;
+		masks.digits[word] = digits & valid;
+		masks.letters[word] = letters & valid;
+		masks.parentheses[word] = parentheses & valid;
+		masks.spaces[word] = spaces & valid;
+		masks.errors[word] = ~(operators | digits | letters | parentheses | spaces) & valid;
+	}
+}
 
-		bool is_operator(char c){
-			if(c == '+' || c == '-' || c == '*' || c == '/' || c == '^'){
-				return true;
-			}
-			return false;
+__attribute__((target("avx2")))
+void classify_bytes_avx2(const char* text, int length, CharacterMasks &masks){
+	int word_count = (length + 63) / 64;
+	masks.resize(word_count);
+
+	char padded[64];
+	for(int word=0; word<word_count; word++){
+		const char* block = text + word * 64;
+		int remaining = length - word * 64;
+		uint64_t valid = ~(uint64_t) 0;
+		if(remaining < 64){
+			memset(padded, 0, 64);
+			memcpy(padded, block, remaining);
+			block = padded;
+			valid = ((uint64_t) 1 << remaining) - 1;
 		}
 
-		bool is_operand(char c){
-			if((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')){
-				return true;
-			}
-			return false;
+		uint64_t operators = 0, digits = 0, letters = 0, parentheses = 0, spaces = 0;
+		for(int part=0; part<2; part++){
+			__m256i x = _mm256_loadu_si256((const __m256i*) (block + part * 32));
+			//c - '0' <= 9 and (c | 0x20) - 'a' <= 25 as unsigned bytes, where min(v, limit) == v means v <= limit
+			__m256i digit_offset = _mm256_sub_epi8(x, _mm256_set1_epi8('0'));
+			__m256i is_digit = _mm256_cmpeq_epi8(_mm256_min_epu8(digit_offset, _mm256_set1_epi8(9)), digit_offset);
+			__m256i letter_offset = _mm256_sub_epi8(_mm256_or_si256(x, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+			__m256i is_letter = _mm256_cmpeq_epi8(_mm256_min_epu8(letter_offset, _mm256_set1_epi8(25)), letter_offset);
+			__m256i is_operator = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('+')), _mm256_cmpeq_epi8(x, _mm256_set1_epi8('-'))),
+					_mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('*')), _mm256_cmpeq_epi8(x, _mm256_set1_epi8('/'))),
+					_mm256_cmpeq_epi8(x, _mm256_set1_epi8('^'))));
+			__m256i is_parenthesis = _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('(')), _mm256_cmpeq_epi8(x, _mm256_set1_epi8(')')));
+			__m256i is_space = _mm256_cmpeq_epi8(x, _mm256_set1_epi8(' '));
+
+			int shift = part * 32;
+			operators |= (uint64_t) (uint32_t) _mm256_movemask_epi8(is_operator) << shift;
+			digits |= (uint64_t) (uint32_t) _mm256_movemask_epi8(is_digit) << shift;
+			letters |= (uint64_t) (uint32_t) _mm256_movemask_epi8(is_letter) << shift;
+			parentheses |= (uint64_t) (uint32_t) _mm256_movemask_epi8(is_parenthesis) << shift;
+			spaces |= (uint64_t) (uint32_t) _mm256_movemask_epi8(is_space) << shift;
 		}
 
-		bool is_number(char c){
-			if(c >= '0' && c <= '9'){
-				return true;
-			}
-			return false;
+		masks.operators[word] = operators & valid;
+		masks.digits[word] = digits & valid;
+		masks.letters[word] = letters & valid;
+		masks.parentheses[word] = parentheses & valid;
+		masks.spaces[word] = spaces & valid;
+		masks.errors[word] = ~(operators | digits | letters | parentheses | spaces) & valid;
+	}
+}
+
+#endif
+
+//The widest mask kernel this CPU runs, or the one named: "scalar", "sse2" or "avx2". Falls back to scalar.
+MaskKernel get_mask_kernel(string name){
+
+	MaskKernel kernel = classify_bytes_scalar;
+
+#ifdef CHARACTER_MASKS_X86
+	__builtin_cpu_init();
+	if((name == "avx2" || name == "") && __builtin_cpu_supports("avx2")){
+		kernel = classify_bytes_avx2;
+	}
+	else if((name == "sse2" || name == "") && __builtin_cpu_supports("sse2")){
+		kernel = classify_bytes_sse2;
+	}
+#endif
+
+	return kernel;
+}
+
+inline int lowest_set_bit(uint64_t bits){
+#ifdef __GNUC__
+	return __builtin_ctzll(bits);
+#else
+	int position = 0;
+	while((bits & 1) == 0){
+		bits >>= 1;
+		position++;
+	}
+	return position;
+#endif
+}
+
+inline int count_set_bits(uint64_t bits){
+#ifdef __GNUC__
+	return __builtin_popcountll(bits);
+#else
+	int count = 0;
+	while(bits != 0){
+		bits &= bits - 1;
+		count++;
+	}
+	return count;
+#endif
+}
+
+//The first position from start on whose bit in mask is clear, or length if there is none. Skips 64 bytes per step.
+int next_clear_bit(const vector<uint64_t> &mask, int start, int length){
+	if(start >= length){
+		return length;
+	}
+	int word = start >> 6;
+	uint64_t clear = ~mask[word] >> (start & 63);
+	if(clear != 0){
+		return min(start + lowest_set_bit(clear), length);
+	}
+	for(word++; word * 64 < length; word++){
+		if(~mask[word] != 0){
+			return min(word * 64 + lowest_set_bit(~mask[word]), length);
 		}
+	}
+	return length;
+}
 
-		bool is_par(char c){
-			if(c == '(' || c == ')'){
-				return true;
+//Splits the expression into tokens once. A token only stores where it is in the input, so nothing is copied.
+class ExpressionLexer{
+
+	private:
+
+	string_view input;
+
+	static const int mask_threshold = 256;
+
+	TokenType char_type(char c){
+		return char_token_type(c);
+	}
+
+	bool is_digit(char c){
+		return char_token_type(c) == DIGIT;
+	}
+
+	//A number is digits, then optionally a fraction (.25) and an exponent (e9, E-3). The dot and the e only belong to
+	//the number when a digit follows them, so "2e" is still a 2 followed by the letter e.
+	int number_length(const char* characters, int start, int input_length){
+		int end = start;
+		while(end < input_length && is_digit(characters[end])){
+			end++;
+		}
+		if(end + 1 < input_length && characters[end] == '.' && is_digit(characters[end + 1])){
+			end++;
+			while(end < input_length && is_digit(characters[end])){
+				end++;
 			}
-			return false;
 		}
-
-		bool is_number(string str){
-			for(int i=0; i<str.length(); i++){
-				if(!is_number(str[i])){
-					return false;
+		if(end < input_length && (characters[end] == 'e' || characters[end] == 'E')){
+			int exponent = end + 1;
+			if(exponent < input_length && (characters[exponent] == '+' || characters[exponent] == '-')){
+				exponent++;
+			}
+			if(exponent < input_length && is_digit(characters[exponent])){
+				end = exponent;
+				while(end < input_length && is_digit(characters[end])){
+					end++;
 				}
 			}
-			return true;
 		}
+		return end - start;
+	}
 
 	public:
 
+	ExpressionLexer(string_view init_input) : input(init_input){
+	}
 
-		Expression(string input){
-			expression = input;
-			this->evaluate_type();
+	//Spaces are dropped and a whole number literal (3, 3.25, 1e9) becomes one DIGIT token. The buffer always ends with
+	//an END token.
+	int tokenize_per_character(vector<Token>& tokens){
+		const char* characters = input.data();
+		int input_length = input.length();
+		int i = 0;
+		int token_count = 0;
+
+		//There are never more tokens than characters, so the buffer is sized once and filled by index.
+		tokens.resize(input_length + 1);
+		while(i < input_length){
+			Token token;
+			token.type = char_type(characters[i]);
+			token.offset = i;
+			token.length = 1;
+
+			if(token.type == END){
+				break;
+			}
+			if(token.type == SPACE){
+				i++;
+				continue;
+			}
+			if(token.type == DIGIT){
+				token.length = number_length(characters, i, input_length);
+			}
+			tokens[token_count] = token;
+			token_count++;
+			i += token.length;
 		}
 
-		string infix_to_prefix(){
+		Token end;
+		end.type = END;
+		end.offset = i;
+		end.length = 0;
+		tokens[token_count] = end;
+		tokens.resize(token_count + 1);
 
-			if(type != INFIX){
-				return "error";
-			}
+		return 0;
+	}
 
-			string prefix = "";
-			string infix = expression;
-			stack<char> op_stack;
-
-			reverse(infix.begin(), infix.end());
-
-			for(int i=0; i<infix.length(); i++){
-				if(is_operand(infix[i])){
-					prefix += infix[i];
-				}
-				else if(is_operator(infix[i]) && op_stack.empty()){
-					op_stack.push(infix[i]);
-				}
-				else if(is_operator(infix[i])){
-					if(get_priority(infix[i]) >= get_priority(op_stack.top())){
-						op_stack.push(infix[i]);
-					} 
-					else if (get_priority(infix[i]) < get_priority(op_stack.top())){
-						while(!op_stack.empty() && get_priority(infix[i]) < get_priority(op_stack.top())){
-							prefix += op_stack.top();
-							op_stack.pop();
-						}
-						op_stack.push(infix[i]);
-					}
-				}
-				else if(infix[i] == ')'){
-					op_stack.push(infix[i]);
-				}
-				else if(infix[i] == '('){
-					while(!op_stack.empty() && op_stack.top() != ')'){
-						prefix += op_stack.top();
-						op_stack.pop();
-					}
-					if(!op_stack.empty()){
-						op_stack.pop();
-					}
-					
-				}
-			}
-			while(!op_stack.empty()){
-				prefix += op_stack.top();
-				op_stack.pop();
+	//Gives the same tokens as tokenize_per_character, read off bit masks of the whole input that kernel builds 16 or
+	//32 bytes at a time. The bits where tokens start are found 64 bytes at a time, so spaces and the inside of digit
+	//runs are never looked at one by one. Only a fraction or exponent after a run is read per character.
+	int tokenize_with_masks(vector<Token>& tokens, MaskKernel kernel){
+		static thread_local CharacterMasks masks;
+		static thread_local vector<uint64_t> start_words;
+		const char* characters = input.data();
+		int input_length = input.length();
+		int word_count = (input_length + 63) / 64;
+		int token_count = 0;
+		int i = input_length;
+		int skip_until = 0;
+
+		kernel(characters, input_length, masks);
+
+		//A digit right after a digit continues a number instead of starting a token. Counting the starts first sizes
+		//the buffer to the tokens instead of to the bytes.
+		uint64_t carry = 0;
+		int start_count = 0;
+		start_words.resize(word_count);
+		for(int word=0; word<word_count; word++){
+			uint64_t digits = masks.digits[word];
+			uint64_t continuing = digits & (digits << 1 | carry);
+			carry = digits >> 63;
+			uint64_t starts = ~masks.spaces[word] & ~continuing;
+			if(input_length - word * 64 < 64){
+				starts &= ((uint64_t) 1 << (input_length - word * 64)) - 1;
 			}
-
-			reverse(prefix.begin(), prefix.end());
-
-			return prefix;
+			start_words[word] = starts;
+			start_count += count_set_bits(starts);
 		}
 
-		string infix_to_postfix(){
-
-			if(type != INFIX){
-				return "error";
+		tokens.resize(start_count + 1);
+		for(int word=0; word<word_count; word++){
+			uint64_t starts = start_words[word];
+			if(skip_until >= (word + 1) * 64){
+				continue;
+			}
+			if(skip_until > word * 64){
+				starts &= ~(uint64_t) 0 << (skip_until - word * 64);
 			}
 
-			string postfix = "";
-			string infix = expression;
-			stack<char> op_stack;
-
-			for(int i=0; i<infix.length(); i++){
-				if(is_operand(infix[i])){
-					postfix += infix[i];
-				}
-				else if(is_operator(infix[i]) && op_stack.empty()){
-					op_stack.push(infix[i]);
-				}
-				else if(is_operator(infix[i])){
-					if(get_priority(infix[i]) > get_priority(op_stack.top())){
-						op_stack.push(infix[i]);
-					} 
-					else if (get_priority(infix[i]) <= get_priority(op_stack.top())){
-						while(!op_stack.empty() && get_priority(infix[i]) <= get_priority(op_stack.top())){
-							postfix += op_stack.top();
-							op_stack.pop();
+			while(starts != 0){
+				i = word * 64 + lowest_set_bit(starts);
+				starts &= starts - 1;
+				uint64_t bit = (uint64_t) 1 << (i & 63);
+				Token token;
+				token.offset = i;
+				token.length = 1;
+
+				if(masks.digits[word] & bit){
+					token.type = DIGIT;
+					token.length = next_clear_bit(masks.digits, i, input_length) - i;
+					if(i + token.length < input_length){
+						char next = characters[i + token.length];
+						if(next == '.' || next == 'e' || next == 'E'){
+							token.length = number_length(characters, i, input_length);
 						}
-						op_stack.push(infix[i]);
 					}
 				}
-				else if(infix[i] == '('){
-					op_stack.push(infix[i]);
+				else if(masks.letters[word] & bit){
+					token.type = LETTER;
 				}
-				else if(infix[i] == ')'){
-					while(!op_stack.empty() && op_stack.top() != '('){
-						postfix += op_stack.top();
-						op_stack.pop();
-					}
-					if(!op_stack.empty()){
-						op_stack.pop();
-					}
+				else if(masks.parentheses[word] & bit){
+					token.type = characters[i] == '(' ? L_PAR : R_PAR;
+				} else {
+					//Which operator, or '_', '\0' and bytes outside the grammar for the errors mask
+					token.type = char_token_type(characters[i]);
 				}
+
+				if(token.type == END){
+					word = word_count;
+					break;
+				}
+				tokens[token_count] = token;
+				token_count++;
+				//A number can run past the bits already taken from starts, also into the next words
+				int end = i + token.length;
+				i = input_length;
+				if(end >= (word + 1) * 64){
+					skip_until = end;
+					break;
+				}
+				starts &= ~(uint64_t) 0 << (end - word * 64);
 			}
-			while(!op_stack.empty()){
-				postfix += op_stack.top();
-				op_stack.pop();
-			}
-			
+		}
 
-			return postfix;
+		Token end;
+		end.type = END;
+		end.offset = i;
+		end.length = 0;
+		tokens[token_count] = end;
+		tokens.resize(token_count + 1);
+
+		return 0;
+	}
+
+	//Short inputs are not worth building masks for
+	int tokenize(vector<Token>& tokens){
+		static MaskKernel best_kernel = get_mask_kernel("");
+		if(input.length() >= mask_threshold){
+			return tokenize_with_masks(tokens, best_kernel);
 		}
+		return tokenize_per_character(tokens);
+	}
 
-		string prefix_to_infix(){
+};
 
+//The infix, prefix and postfix grammars as one state machine that is handed a token at a time and keeps nothing but
+//counters, so it can stop between any two tokens and carry on when the next one arrives.
+class NotationRecognizer{
 
-			if(type != PREFIX){
-				return "error";
-			}
+	private:
 
-			string infix = "";
-			string prefix = expression;
-			stack<string> op_stack;
+	bool infix_valid, prefix_valid, postfix_valid;
+	bool expecting_operand;			//infix: <factor> is expected next
+	long long par_depth;			//infix: open parentheses
+	long long operands_needed;		//prefix: <expr> still to be read
+	long long stack_size;			//postfix: operands on the stack
 
-			reverse(prefix.begin(), prefix.end());
+	bool is_operator(TokenType type){
+		return token_type_table.is_operator[type];
+	}
 
-			for(int i=0; i<prefix.length(); i++){
-				
-				if(is_operand(prefix[i])){
-					string operand = "";
-					operand.push_back(prefix[i]);
-					op_stack.push(operand);
-				}
-				else if(is_operator(prefix[i])){
-					if(op_stack.size() < 2){
-						return "error";
-					}
-					infix += "(";
-					string operand_one = op_stack.top();
-					op_stack.pop();
-					string operand_two = op_stack.top();
-					op_stack.pop();
-					int op_one_prio, op_two_prio, current_op_prio = get_priority(prefix[i]);
-					if(operand_one.length() == 1){
-						op_one_prio = 0;
-					} else {
-						// op_one_prio = get_priority(operand_one.at(operand_one.length() - 3));
-						op_one_prio = get_least_priority(operand_one);
-					}
-					if(operand_two.length() == 1){
-						op_two_prio = 0;
-					} else {
-						// op_two_prio = get_priority(operand_two.at(operand_two.length() - 3));
-						op_two_prio = get_least_priority(operand_two);
-					}
-					if(op_one_prio >= current_op_prio){
-						operand_one.erase(0,1);
-						operand_one.pop_back();
-					}
-					if(op_two_prio >= current_op_prio){
-						operand_two.erase(0,1);
-						operand_two.pop_back();
-					}
-					infix += operand_one + prefix[i] + operand_two;
-					/*
-					if(op_one_prio == op_two_prio){
-						if(op_one_prio >= current_op_prio){
-							operand_one.erase(0,1);
-							operand_one.pop_back();
-							operand_two.erase(0,1);
-							operand_two.pop_back();
-							infix += operand_one + prefix[i] + operand_two;
-						} else {
-							infix += operand_one + prefix[i] + operand_two;
-						}
-					} else {
-						if(op_one_prio >= current_op_prio){
-							operand_one.erase(0,1);
-							operand_one.pop_back();
-						}
-						if(op_two_prio >= current_op_prio){
-							operand_two.erase(0,1);
-							operand_two.pop_back();
-						}
-						infix += operand_one + prefix[i] + operand_two;
-					}
-					*/
-					infix += ")";
-					/*
-					infix += "(";
-					infix += op_stack.top();
-					op_stack.pop();
-					infix += prefix[i];
-					infix += op_stack.top();
-					op_stack.pop();
-					infix += ")";
-					*/
-					op_stack.push(infix);
-					infix.clear();
-					
-				}
-			}
-			infix = op_stack.top();
-			infix.erase(0,1);
-			infix.pop_back();
-			return infix;
+	bool is_operand(TokenType type){
+		return token_type_table.is_operand[type];
+	}
 
-			
-		}
+	public:
 
-		string prefix_to_postfix(){
+	NotationRecognizer(){
+		reset();
+	}
 
-			if(type != PREFIX){
-				return "error";
-			}
+	void reset(void){
+		infix_valid = true;
+		prefix_valid = true;
+		postfix_valid = true;
+		expecting_operand = true;
+		par_depth = 0;
+		operands_needed = 1;
+		stack_size = 0;
+	}
 
-			string postfix = "";
-			string prefix = expression;
-			stack<string> op_stack;
-
-			reverse(prefix.begin(), prefix.end());
-
-			for(int i=0; i<prefix.length(); i++){
-				if(is_operand(prefix[i])){
-					string operand = "";
-					operand.push_back(prefix[i]);
-					op_stack.push(operand);
-				} else if(is_operator(prefix[i])){
-					if(op_stack.size() < 2){
-						return "error";
-					}
-					
-					postfix += op_stack.top();
-					op_stack.pop();
-					postfix += op_stack.top();
-					op_stack.pop();
-					postfix += prefix[i];
-					op_stack.push(postfix);
-					
-					postfix.clear();
-					
-				}
+	//Moves every grammar one token on.
+	void read(TokenType type){
+		if(is_operand(type)){
+			if(!expecting_operand){
+				infix_valid = false;
 			}
-			
-			postfix = op_stack.top();
-		
+			expecting_operand = false;
+			if(operands_needed == 0){
+				prefix_valid = false;
+			}
+			operands_needed--;
+			stack_size++;
+		}
+		else if(is_operator(type)){
+			if(expecting_operand){
+				infix_valid = false;
+			}
+			expecting_operand = true;
+			if(operands_needed == 0){
+				prefix_valid = false;
+			}
+			operands_needed++;
+			if(stack_size < 2){
+				postfix_valid = false;
+			}
+			stack_size--;
+		}
+		else if(type == L_PAR){
+			if(!expecting_operand){
+				infix_valid = false;
+			}
+			par_depth++;
+			prefix_valid = false;
+			postfix_valid = false;
+		}
+		else if(type == R_PAR){
+			if(expecting_operand || par_depth == 0){
+				infix_valid = false;
+			}
+			par_depth--;
+			prefix_valid = false;
+			postfix_valid = false;
+		}
+		else {
+			infix_valid = false;
+			prefix_valid = false;
+			postfix_valid = false;
+		}
+	}
 
-			return postfix;
+	//Checks notation alone, for a caller that has already ruled out the other two grammars, so a read stops
+	//counting as soon as that one fails
+	void only(ExpressionType notation){
+		infix_valid = infix_valid && notation == INFIX;
+		prefix_valid = prefix_valid && notation == PREFIX;
+		postfix_valid = postfix_valid && notation == POSTFIX;
+	}
+
+	//The only grammar that can still accept the input, or ERROR_EXPR while two or more can
+	ExpressionType survivor(void){
+		if(infix_valid && !prefix_valid && !postfix_valid){
+			return INFIX;
 		}
+		else if(prefix_valid && !infix_valid && !postfix_valid){
+			return PREFIX;
+		}
+		else if(postfix_valid && !infix_valid && !prefix_valid){
+			return POSTFIX;
+		}
+		return ERROR_EXPR;
+	}
 
-		string postfix_to_infix(){
+	bool infix_expecting_operand(void){
+		return expecting_operand;
+	}
 
-			if(type != POSTFIX){
-				return "error";
-			}
+	long long infix_par_depth(void){
+		return par_depth;
+	}
 
-			string postfix = expression;
-			string infix = "";
-			stack<string> op_stack;
+	long long prefix_operands_needed(void){
+		return operands_needed;
+	}
 
-			
+	long long postfix_stack_size(void){
+		return stack_size;
+	}
 
-			for(int i=0; i<postfix.length(); i++){
-				
-				if(is_operand(postfix[i])){
-					string operand = "";
-					operand.push_back(postfix[i]);
-					op_stack.push(operand);
-				}
-				else if(is_operator(postfix[i])){
-					if(op_stack.size() < 2){
-						return "error";
-					}
-					infix += "(";
-					string operand_one = op_stack.top();
-					op_stack.pop();
-					string operand_two = op_stack.top();
-					op_stack.pop();
-					int op_one_prio, op_two_prio, current_op_prio = get_priority(postfix[i]);
-					if(operand_one.length() == 1){
-						op_one_prio = 0;
-					} else {
-						// op_one_prio = get_priority(operand_one.at(operand_one.length() - 3));
-						op_one_prio = get_least_priority(operand_one);
-					}
-					if(operand_two.length() == 1){
-						op_two_prio = 0;
-					} else {
-						// op_two_prio = get_priority(operand_two.at(operand_two.length() - 3));
-						op_two_prio = get_least_priority(operand_two);
-					}
-					if(op_one_prio >= current_op_prio){
-						operand_one.erase(0,1);
-						operand_one.pop_back();
-					}
-					if(op_two_prio >= current_op_prio){
-						operand_two.erase(0,1);
-						operand_two.pop_back();
-					}
-					infix += operand_two + postfix[i] + operand_one;
-					/*
-					if(op_one_prio == op_two_prio){
-						if(op_one_prio >= current_op_prio){
-							operand_one.erase(0,1);
-							operand_one.pop_back();
-							operand_two.erase(0,1);
-							operand_two.pop_back();
-							infix += operand_one + prefix[i] + operand_two;
-						} else {
-							infix += operand_one + prefix[i] + operand_two;
-						}
-					} else {
-						if(op_one_prio >= current_op_prio){
-							operand_one.erase(0,1);
-							operand_one.pop_back();
-						}
-						if(op_two_prio >= current_op_prio){
-							operand_two.erase(0,1);
-							operand_two.pop_back();
-						}
-						infix += operand_one + prefix[i] + operand_two;
-					}
-					*/
-					infix += ")";
-					/*
-					infix += "(";
-					infix += op_stack.top();
-					op_stack.pop();
-					infix += prefix[i];
-					infix += op_stack.top();
-					op_stack.pop();
-					infix += ")";
-					*/
-					op_stack.push(infix);
-					infix.clear();
-					
-				}
-			}
-			infix = op_stack.top();
-			infix.erase(0,1);
-			infix.pop_back();
-			return infix;
+	//No grammar can accept the input any more, whatever follows
+	bool failed(void){
+		return !infix_valid && !prefix_valid && !postfix_valid;
+	}
 
+	//The notation of the tokens read so far, if they were the whole expression
+	ExpressionType verdict(void){
+		if(infix_valid && !expecting_operand && par_depth == 0){
+			return INFIX;
 		}
+		else if(prefix_valid && operands_needed == 0){
+			return PREFIX;
+		}
+		else if(postfix_valid && stack_size == 1){
+			return POSTFIX;
+		}
+		return ERROR_EXPR;
+	}
 
-		string postfix_to_prefix(){
-
-			if(type != POSTFIX){
-				return "error";
-			}
+};
 
-			string postfix = expression;
-			string prefix = "";
-			stack<string> op_stack;
-
-			// reverse(postfix.begin(), postfix.end());
-
-			for(int i=0; i<postfix.length(); i++){
-				if(is_operand(postfix[i])){
-					string operand = "";
-					operand.push_back(postfix[i]);
-					op_stack.push(operand);
-				} else if(is_operator(postfix[i])){
-					if(op_stack.size() < 2){
-						return "error";
-					}
-					prefix += postfix[i];
-					string operand_one = op_stack.top();
-					op_stack.pop();
-					string operand_two = op_stack.top();
-					op_stack.pop();
-					
+//Runs the infix, prefix and postfix grammars side by side over one token buffer so the notation is known after a single pass.
+class ExpressionClassifier{
 
-					prefix += operand_two + operand_one;
-					op_stack.push(prefix);
-					
-					prefix.clear();
-					
-				}
-			}
+	private:
 
-			prefix = op_stack.top();
+	const vector<Token>& tokens;
+	long long max_depth;		//deepest nesting accepted, as for the parsers
 
-			return prefix;
+	//Only infix is left: the rest is read with whether an operand comes next and how many parentheses are open
+	ExpressionType finish_infix(int i, bool expecting_operand, long long par_depth){
+		if(par_depth > max_depth){
+			return ERROR_EXPR;
 		}
-		
-		int get_equivalents(){
-			
-			cout << "Getting Equivalent Form of Expression Input" << endl;
-			cout << "-------------------------------------------" << endl;
-
-			cout << "Expression:\t" << expression << endl;
-			cout << "Type: ";
-			if(type == INFIX){
-				cout << "\t\tINFIX" << endl;
-				cout << "Prefix:\t\t" << infix_to_prefix() << endl;
-				cout << "Postfix:\t" << infix_to_postfix() << endl;
-			} else if(type == PREFIX){
-				cout << "\t\tPREFIX" << endl;
-				cout << "Infix:\t\t" << prefix_to_infix() << endl;
-				cout << "Postfix:\t" << prefix_to_postfix() << endl;
-			} else if(type == POSTFIX){
-				cout << "\t\tPOSTFIX" << endl;
-				cout << "Infix:\t\t" << postfix_to_infix() << endl;
-				cout << "Prefix:\t\t" << postfix_to_prefix() << endl;
+		for(; tokens[i].type != END; i++){
+			TokenType type = tokens[i].type;
+			if(expecting_operand){
+				if(token_type_table.is_operand[type]){
+					expecting_operand = false;
+				}
+				else if(type == L_PAR && par_depth < max_depth){
+					par_depth++;
+				} else {
+					return ERROR_EXPR;
+				}
 			} else {
-				cout << "\t\tERROR_EXPR" << endl;
+				if(token_type_table.is_operator[type]){
+					expecting_operand = true;
+				}
+				else if(type == R_PAR && par_depth > 0){
+					par_depth--;
+				} else {
+					return ERROR_EXPR;
+				}
 			}
-
-			return 0;
 		}
+		if(expecting_operand || par_depth != 0){
+			return ERROR_EXPR;
+		}
+		return INFIX;
+	}
 
-		int evaluate(void){
-			
-			if(type == ERROR_EXPR){
-				cout << "ERRONEOUS EXPRESSION. CANNOT EVALUATE" << endl;
-				return -1;
+	//Only postfix is left: the rest is read with nothing but the height of the operand stack. An operator needs two
+	//operands, so the height never drops below 1 in a valid expression.
+	ExpressionType finish_postfix(int i, long long stack_size){
+		if(stack_size > max_depth + 1){
+			return ERROR_EXPR;
+		}
+		for(; tokens[i].type != END; i++){
+			TokenType type = tokens[i].type;
+			stack_size += token_type_table.is_operand[type] - token_type_table.is_operator[type];
+			if(stack_size < 1 || stack_size > max_depth + 1 || token_type_table.is_operand[type] == token_type_table.is_operator[type]){
+				return ERROR_EXPR;
 			}
+		}
+		if(stack_size != 1){
+			return ERROR_EXPR;
+		}
+		return POSTFIX;
+	}
 
-			for(int i=0; i<expression.length(); i++){
-				if(expression[i]==' ' || expression[i]=='\t' || expression[i]=='\n'){
-					continue;
-				}
-				// cout << "expression [i]" << expression[i] << endl;
-				if(!is_number(expression[i]) && !is_operator(expression[i]) && !is_par(expression[i])){
-					cout << "NON NUMERIC EXPRESSION. CANNOT EVALUATE" << endl;
-					return -1;
-				}
+	//Only prefix is left: the rest is read with nothing but the count of <expr>s still owed
+	ExpressionType finish_prefix(int i, long long operands_needed){
+		if(operands_needed > max_depth + 1){
+			return ERROR_EXPR;
+		}
+		for(; tokens[i].type != END; i++){
+			TokenType type = tokens[i].type;
+			if(operands_needed == 0 || token_type_table.is_operand[type] == token_type_table.is_operator[type]){
+				return ERROR_EXPR;
 			}
+			if(token_type_table.is_operator[type] && operands_needed > max_depth){
+				return ERROR_EXPR;
+			}
+			operands_needed += token_type_table.is_operator[type] - token_type_table.is_operand[type];
+		}
+		if(operands_needed != 0){
+			return ERROR_EXPR;
+		}
+		return PREFIX;
+	}
 
-			stack<string> postfix = to_postfix_stack();
+	//Reads with every grammar until one is left, which is within the first two tokens for most input, and hands the
+	//rest to a loop for that grammar alone
+	ExpressionType run(NotationRecognizer &recognizer){
+		for(int i=0; tokens[i].type != END; i++){
+			recognizer.read(tokens[i].type);
+			if(recognizer.failed()){
+				return ERROR_EXPR;
+			}
 
-			// print_stack(postfix);
+			ExpressionType survivor = recognizer.survivor();
+			if(survivor == POSTFIX){
+				return finish_postfix(i + 1, recognizer.postfix_stack_size());
+			}
+			else if(survivor == PREFIX){
+				return finish_prefix(i + 1, recognizer.prefix_operands_needed());
+			}
+			else if(survivor == INFIX){
+				return finish_infix(i + 1, recognizer.infix_expecting_operand(), recognizer.infix_par_depth());
+			}
+		}
 
-			double answer;
-			bool initial = true;
-			//solve here
+		return recognizer.verdict();
+	}
 
-			stack<double> operands;
+	public:
 
-			while(!postfix.empty()){
-				if(is_number(postfix.top())){
-					operands.push(stoi(postfix.top()));
-				} 
-				else {
-					if(operands.size() < 2){
-						cout << "Stack Errror" << endl;
-						return -1;
-					}
-					int op_two = operands.top();
-					operands.pop();
-					int op_one = operands.top();
-					operands.pop();
-					double result;
-					if(postfix.top().compare("+") == 0){
-						result = op_one + op_two;
-					}
-					else if(postfix.top().compare("-") == 0){
-						result = op_one - op_two;
-					}
-					else if(postfix.top().compare("*") == 0){
-						result = op_one * op_two;
-					}
-					else if(postfix.top().compare("/") == 0){
-						if(op_two == 0){
-							cout << "Division by Zero Error" << endl;
-							return -1;
-						}
-						result = op_one / op_two;
-					}
-					else if(postfix.top().compare("^") == 0){
-						result = pow(op_one, op_two);
-					}
-					operands.push(result);
-				}
-				postfix.pop();
-			}
+	ExpressionClassifier(const vector<Token>& init_tokens) : tokens(init_tokens){
+		max_depth = ExpressionParser::default_max_depth;
+	}
 
-			if(operands.size() != 1){
-				cout << "Error" << endl;
-				return -1;
-			} else {
-				answer = operands.top();
-			}
+	//Limits nesting the way ExpressionParser::set_max_depth does: open parentheses in infix, operators waiting for
+	//an operand in prefix, and operands waiting for an operator in postfix
+	void set_max_depth(int depth){
+		max_depth = depth;
+	}
 
-			cout << "Expression:\t" << expression << endl;
-			cout << "Answer:\t" << answer << endl;
-			
+	ExpressionType classify(void){
+		NotationRecognizer recognizer;
+		return run(recognizer);
+	}
 
-			return 0;
-		}
+	//PREFIX or ERROR_EXPR, stopping at the first token the prefix grammar rejects
+	ExpressionType classify_prefix(void){
+		NotationRecognizer recognizer;
+		recognizer.only(PREFIX);
+		return run(recognizer);
+	}
 
-		void print_stack(stack<string> print){
-			int i=0;
-			while(!print.empty()){
-				cout << i << ":" << print.top() << endl;
-				print.pop();
-				i++;
-			}
-		}
+};
 
-		stack<string> to_postfix_stack(){
+//How far a number literal split across chunks has been read: 12, 12., 12.5, 12.5e, 12.5e- or 12.5e-3
+enum NumberState{
 
-			stack<string> postfix;
-			string current_token = "";
-			if(type == INFIX){
-				stack<char> op_stack;
-				for(int i=0; i<expression.length(); i++){
-					if(expression[i]==' '){
-						continue;
-					}
-					
-					if(is_number(expression[i])){
-						while(i<expression.length() && expression[i]!= ' '){
-							current_token += expression[i];
-							i++;
-						}
-						postfix.push(current_token);
-						current_token.clear();
-					}
-					else if(is_operator(expression[i]) && op_stack.empty()){
-						op_stack.push(expression[i]);
-					}
-					else if(is_operator(expression[i])){
-						if(get_priority(expression[i]) > get_priority(op_stack.top())){
-							op_stack.push(expression[i]);
-						} 
-						else if (get_priority(expression[i]) <= get_priority(op_stack.top())){
-							while(!op_stack.empty() && get_priority(expression[i]) <= get_priority(op_stack.top())){
-								string op = "";
-								op += op_stack.top();
-								op_stack.pop();
-								postfix.push(op);
-								op.clear();
-							}
-							op_stack.push(expression[i]);
-						}
-					}
-					else if(expression[i] == '('){
-						op_stack.push(expression[i]);
-					}
-					else if(expression[i] == ')'){
-						while(!op_stack.empty() && op_stack.top()!= '('){
-							current_token += op_stack.top();
-							op_stack.pop();
-							postfix.push(current_token);
-							current_token.clear();
-						}
-						if(!op_stack.empty()){
-							op_stack.pop();
-						}
-					}
-				}
-				string op = "";
-				while(!op_stack.empty()){
-					op += op_stack.top();
-					op_stack.pop();
-					postfix.push(op);
-					op.clear();
-				}
-				vector<string> reversal;
-				while(!postfix.empty()){
-					reversal.push_back(postfix.top());
-					postfix.pop();
-				}
-				for(int i=0; i<reversal.size(); i++){
-					postfix.push(reversal.at(i));
-				}
+	NOT_IN_NUMBER,
+	INTEGER_PART,
+	DECIMAL_POINT,
+	FRACTION,
+	EXPONENT_MARK,
+	EXPONENT_SIGN,
+	EXPONENT_DIGITS
 
-			}
-			else if(type == PREFIX){
-				string prefix = expression;
-				stack< vector<string> > op_stack;
-				vector<string> postfix_temp;
-				vector<string> tokens;
+};
 
-				reverse(prefix.begin(), prefix.end());
-				// postfix.push("$");
-				for(int i=0; i<prefix.length(); i++){
-					if(is_number(prefix[i])){
-						while(i<prefix.length() && is_number(prefix[i])){
-							current_token += prefix[i];
-							i++;
-						}
-						tokens.push_back(current_token);
-						op_stack.push(tokens);
-						current_token.clear();
-						tokens.clear();
-					} else if(is_operator(prefix[i])){
-						if(op_stack.size() < 2){
-							cout << "error encountered. empty stack returned." << endl;
-							while(!postfix.empty()){
-								postfix.pop();
-							}
-							return postfix;
-						}
-						// postfix.push(op_stack.top());
-						// op_stack.pop();
-						// while(!op_stack.empty() && postfix.top().compare("$")!=0){
-						// 	postfix.push(op_stack.top());
-						// 	op_stack.pop();
-						// }
-						// current_token += prefix[i];
-						// postfix.push(current_token);
-						// current_token.clear();
-
-						// do{
-						// 	if(op_stack.empty()){
-						// 		break;
-						// 	}
-						// 	tokens.push_back(op_stack.top());
-						// 	op_stack.pop();
-						// } while(!op_stack.empty() && !is_operator(op_stack.top()));
-						// postfix_temp.push(tokens);
-						// tokens.clear();
-						// do{
-						// 	if(op_stack.empty()){
-						// 		break;
-						// 	}
-						// 	tokens.push_back(op_stack.top());
-						// 	op_stack.pop();
-						// } while(!op_stack.empty() && !is_operator(op_stack.top()));
-						// postfix_temp.push(tokens);
-						// tokens.clear();
-						// current_token += prefix[i];
-						// tokens.push_back(current_token);
-						// op_stack.push(tokens);
-						// tokens.clear();
-
-						for(int j=0; j<op_stack.top().size(); j++){
-							postfix_temp.push_back(op_stack.top().at(j));
-						}
-						op_stack.pop();
-						for(int j=0; j<op_stack.top().size(); j++){
-							postfix_temp.push_back(op_stack.top().at(j));
-						}
-						op_stack.pop();
-						current_token += prefix[i];
-						postfix_temp.push_back(current_token);
-						current_token.clear();
-						op_stack.push(postfix_temp);
-						postfix_temp.clear();
+//The state after c when c extends a number in state, with the lexer's rules, or NOT_IN_NUMBER when the number ends
+//before c
+NumberState next_number_state(NumberState state, char c){
+	bool digit = c >= '0' && c <= '9';
 
+	if(digit && (state == INTEGER_PART || state == FRACTION || state == EXPONENT_DIGITS)){
+		return state;
+	}
+	else if(digit && state == DECIMAL_POINT){
+		return FRACTION;
+	}
+	else if(digit){
+		return EXPONENT_DIGITS;
+	}
+	else if(c == '.' && state == INTEGER_PART){
+		return DECIMAL_POINT;
+	}
+	else if((c == 'e' || c == 'E') && (state == INTEGER_PART || state == FRACTION)){
+		return EXPONENT_MARK;
+	}
+	else if((c == '+' || c == '-') && state == EXPONENT_MARK){
+		return EXPONENT_SIGN;
+	}
+	return NOT_IN_NUMBER;
+}
 
-					}
-				}
+//Bits of ScreenTable::classes
+enum ScreenClass{
 
-				vector<string> cleaner = op_stack.top();
-				// while(!postfix_temp.empty()){
-				// 	cleaner.push_back(postfix.top());
-				// 	postfix.pop();
-				// }
-				for(int i=cleaner.size()-1; i>=0; i--){
-					postfix.push(cleaner.at(i));
-				}
-				
+	SCREEN_DIGIT = 1,
+	SCREEN_LETTER = 2,
+	SCREEN_ILLEGAL = 4,
+	SCREEN_ERROR_TOKEN = 8
 
-			} else if(type == POSTFIX){
-				string token = "";
-				vector<string> tokens;
-				for(int i=0; i<expression.size(); i++){
-					while(i<expression.size() && expression[i] != ' '){
-						token += expression[i];
-						i++;
-					}
-					tokens.push_back(token);
-					token.clear();
-				}
-				for(int i=tokens.size()-1; i>=0; i--){
-					postfix.push(tokens.at(i));
-				}
-			}
+};
 
-			return postfix;
+//What ExpressionScreen adds up for each character. The operand, operator, '(' and ')' counts are 16 bit fields of one
+//word, so a single addition per character keeps all four.
+struct ScreenTable{
 
+	unsigned long long weights[256];
+	unsigned char classes[256];
 
+};
 
+constexpr ScreenTable make_screen_table(){
+	ScreenTable table = {};
+	for(int c=0; c<256; c++){
+		TokenType type = character_table.types[c];
+		if(token_type_table.is_operand[type]){
+			table.weights[c] = 1;
+		}
+		else if(token_type_table.is_operator[type]){
+			table.weights[c] = 1ULL << 16;
+		}
+		else if(type == L_PAR){
+			table.weights[c] = 1ULL << 32;
+		}
+		else if(type == R_PAR){
+			table.weights[c] = 1ULL << 48;
 		}
-		
 
-};
+		if(type == DIGIT){
+			table.classes[c] = SCREEN_DIGIT;
+		}
+		else if(type == LETTER){
+			table.classes[c] = SCREEN_LETTER;
+		}
+		else if(type == UNDERSCORE){
+			table.classes[c] = SCREEN_ILLEGAL;
+		}
+		else if(type == ERROR_TOKEN){
+			table.classes[c] = SCREEN_ERROR_TOKEN;
+		}
+	}
+	return table;
+}
 
-class ExpressionsTester{
+constexpr ScreenTable screen_table = make_screen_table();
 
+//One cheap pass over the raw text that throws out input no grammar could accept before it is lexed or parsed: a
+//character that is no token of any grammar, parentheses that do not balance, or more or fewer operands than one
+//past the operators. Passing says nothing about the order of the tokens, which is left to the parsers.
+class ExpressionScreen{
 
 	private:
 
-	vector<string> infix_expressions;
-	vector<string> prefix_expressions;
-	vector<string> postfix_expressions;
+	string_view input;
+	long long operators, operands;
+	NumberState number_state;
 
+	//A number cut off after its point is followed by a '.' token, which no grammar has. One cut off after its exponent
+	//mark leaves the mark as a letter, and the sign after it as an operator.
+	bool end_number(void){
+		if(number_state == DECIMAL_POINT){
+			return false;
+		}
+		operands++;
+		if(number_state == EXPONENT_MARK || number_state == EXPONENT_SIGN){
+			operands++;
+		}
+		if(number_state == EXPONENT_SIGN){
+			operators++;
+		}
+		number_state = NOT_IN_NUMBER;
+		return true;
+	}
+
+	//Reads every number the way the lexer does, for input with a '.' or an exponent mark
+	bool rejects_exactly(void){
+		long long depth = 0;
+		operators = 0;
+		operands = 0;
+		number_state = NOT_IN_NUMBER;
+
+		for(int i=0; i<(int) input.length(); i++){
+			char c = input[i];
+			if(number_state != NOT_IN_NUMBER){
+				NumberState next = next_number_state(number_state, c);
+				if(next != NOT_IN_NUMBER){
+					number_state = next;
+					continue;
+				}
+				if(!end_number()){
+					return true;
+				}
+			}
+
+			TokenType type = char_token_type(c);
+			if(type == END){
+				break;
+			}
+			else if(type == DIGIT){
+				number_state = INTEGER_PART;
+			}
+			else if(type == LETTER){
+				operands++;
+			}
+			else if(token_type_table.is_operator[type]){
+				operators++;
+			}
+			else if(type == L_PAR){
+				depth++;
+			}
+			else if(type == R_PAR){
+				if(depth == 0){
+					return true;
+				}
+				depth--;
+			}
+			else if(type != SPACE){
+				return true;
+			}
+		}
+
+		if(number_state != NOT_IN_NUMBER && !end_number()){
+			return true;
+		}
+		return depth != 0 || operators + 1 != operands;
+	}
+
+	public:
+
+	ExpressionScreen(string_view init_input){
+		input = init_input;
+	}
+
+	//One table lookup and addition per character and no branch but the end test, since most input
+	//passes and pays for the whole scan. The packed counts are unpacked every 65535 characters, before a field
+	//can overflow.
+	bool rejects(void){
+		long long operands = 0, operators = 0, opened = 0, closed = 0, continued = 0, exponents = 0;
+		unsigned char seen = 0, previous = 0;
+		const char* text = input.data();
+		int length = input.length();
+		int i = 0;
+
+		while(i < length){
+			int stop = min(length, i + 65535);
+			unsigned long long sums = 0;
+			for(; i<stop && text[i] != '\0'; i++){
+				unsigned char c = text[i];
+				unsigned char type = screen_table.classes[c];
+				sums += screen_table.weights[c];
+				seen |= type;
+				//a digit right after a digit is the same <number>
+				continued += previous & type & SCREEN_DIGIT;
+				//a letter after a digit may be an exponent mark
+				exponents += previous & (type >> 1) & SCREEN_DIGIT;
+				previous = type;
+			}
+			operands += sums & 0xFFFF;
+			operators += (sums >> 16) & 0xFFFF;
+			opened += (sums >> 32) & 0xFFFF;
+			closed += sums >> 48;
+			if(i < stop){
+				break;		//a '\0' ends the expression, as it does for the lexer
+			}
+		}
+
+		if((seen & SCREEN_ILLEGAL) || opened != closed){
+			return true;
+		}
+		//A '.' is an ERROR_TOKEN unless it is inside a number, so any ERROR_TOKEN is left to the exact scan
+		if((seen & SCREEN_ERROR_TOKEN) || exponents != 0){
+			return rejects_exactly();
+		}
+		return operands - continued != operators + 1;
+	}
+
+};
+
+enum OpCode{
+
+	PUSH_CONST,
+	PUSH_VAR,
+
+	ADD,
+	SUB,
+	MUL,
+	DIV,
+	POW
+
+};
+
+struct Instruction{
+
+	OpCode op;
+	int operand;	//index into the constants for PUSH_CONST, variable slot for PUSH_VAR
+
+};
+
+//Names of the variables in a row of values: the variable at position i of the table is read from row[i].
+class SymbolTable{
+
+	private:
+
+	vector<string> names;
+
+	public:
+
+	int add(string name){
+		int index = find(name);
+		if(index != -1){
+			return index;
+		}
+		names.push_back(name);
+		return names.size() - 1;
+	}
+
+	int find(string name){
+		for(int i=0; i<(int) names.size(); i++){
+			if(names.at(i) == name){
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	string name_at(int index){
+		return names.at(index);
+	}
+
+	int size(void){
+		return names.size();
+	}
+
+};
+
+//Column kernels: each one applies an operator to n rows, out[i] = a[i] op b[i]. out may be the same array as a.
+//The SSE2 and AVX2 versions are compiled with target attributes and picked at runtime, so no special flags are needed.
+
+typedef void (*ColumnKernel)(const double* a, const double* b, double* out, int n);
+
+struct ColumnKernels{
+
+	string name;
+	ColumnKernel add;
+	ColumnKernel sub;
+	ColumnKernel mul;
+	ColumnKernel div;
+	ColumnKernel pow;
+
+};
+
+void add_columns_scalar(const double* a, const double* b, double* out, int n){
+	for(int i=0; i<n; i++){
+		out[i] = a[i] + b[i];
+	}
+}
+
+void sub_columns_scalar(const double* a, const double* b, double* out, int n){
+	for(int i=0; i<n; i++){
+		out[i] = a[i] - b[i];
+	}
+}
+
+void mul_columns_scalar(const double* a, const double* b, double* out, int n){
+	for(int i=0; i<n; i++){
+		out[i] = a[i] * b[i];
+	}
+}
+
+void div_columns_scalar(const double* a, const double* b, double* out, int n){
+	for(int i=0; i<n; i++){
+		out[i] = a[i] / b[i];
+	}
+}
+
+//There is no vector pow instruction, so every kernel set uses this one
+void pow_columns_scalar(const double* a, const double* b, double* out, int n){
+	for(int i=0; i<n; i++){
+		out[i] = pow(a[i], b[i]);
+	}
+}
+
+#ifdef COLUMN_KERNELS_X86
+
+__attribute__((target("sse2")))
+void add_columns_sse2(const double* a, const double* b, double* out, int n){
+	int i = 0;
+	for(; i + 2 <= n; i += 2){
+		_mm_storeu_pd(out + i, _mm_add_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+	}
+	for(; i<n; i++){
+		out[i] = a[i] + b[i];
+	}
+}
+
+__attribute__((target("sse2")))
+void sub_columns_sse2(const double* a, const double* b, double* out, int n){
+	int i = 0;
+	for(; i + 2 <= n; i += 2){
+		_mm_storeu_pd(out + i, _mm_sub_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+	}
+	for(; i<n; i++){
+		out[i] = a[i] - b[i];
+	}
+}
+
+__attribute__((target("sse2")))
+void mul_columns_sse2(const double* a, const double* b, double* out, int n){
+	int i = 0;
+	for(; i + 2 <= n; i += 2){
+		_mm_storeu_pd(out + i, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+	}
+	for(; i<n; i++){
+		out[i] = a[i] * b[i];
+	}
+}
+
+__attribute__((target("sse2")))
+void div_columns_sse2(const double* a, const double* b, double* out, int n){
+	int i = 0;
+	for(; i + 2 <= n; i += 2){
+		_mm_storeu_pd(out + i, _mm_div_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+	}
+	for(; i<n; i++){
+		out[i] = a[i] / b[i];
+	}
+}
+
+__attribute__((target("avx2")))
+void add_columns_avx2(const double* a, const double* b, double* out, int n){
+	int i = 0;
+	for(; i + 4 <= n; i += 4){
+		_mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+	}
+	for(; i<n; i++){
+		out[i] = a[i] + b[i];
+	}
+}
+
+__attribute__((target("avx2")))
+void sub_columns_avx2(const double* a, const double* b, double* out, int n){
+	int i = 0;
+	for(; i + 4 <= n; i += 4){
+		_mm256_storeu_pd(out + i, _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+	}
+	for(; i<n; i++){
+		out[i] = a[i] - b[i];
+	}
+}
+
+__attribute__((target("avx2")))
+void mul_columns_avx2(const double* a, const double* b, double* out, int n){
+	int i = 0;
+	for(; i + 4 <= n; i += 4){
+		_mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+	}
+	for(; i<n; i++){
+		out[i] = a[i] * b[i];
+	}
+}
+
+__attribute__((target("avx2")))
+void div_columns_avx2(const double* a, const double* b, double* out, int n){
+	int i = 0;
+	for(; i + 4 <= n; i += 4){
+		_mm256_storeu_pd(out + i, _mm256_div_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+	}
+	for(; i<n; i++){
+		out[i] = a[i] / b[i];
+	}
+}
+
+#endif
+
+//Returns the kernels called name ("scalar", "sse2" or "avx2"), or the scalar ones if this CPU cannot run them.
+//An empty name picks the best set the CPU supports.
+ColumnKernels get_column_kernels(string name){
+
+	ColumnKernels kernels;
+	kernels.name = "scalar";
+	kernels.add = add_columns_scalar;
+	kernels.sub = sub_columns_scalar;
+	kernels.mul = mul_columns_scalar;
+	kernels.div = div_columns_scalar;
+	kernels.pow = pow_columns_scalar;
+
+#ifdef COLUMN_KERNELS_X86
+	__builtin_cpu_init();
+	bool has_avx2 = __builtin_cpu_supports("avx2");
+	bool has_sse2 = __builtin_cpu_supports("sse2");
+
+	if((name == "avx2" || name == "") && has_avx2){
+		kernels.name = "avx2";
+		kernels.add = add_columns_avx2;
+		kernels.sub = sub_columns_avx2;
+		kernels.mul = mul_columns_avx2;
+		kernels.div = div_columns_avx2;
+	}
+	else if((name == "sse2" || name == "") && has_sse2){
+		kernels.name = "sse2";
+		kernels.add = add_columns_sse2;
+		kernels.sub = sub_columns_sse2;
+		kernels.mul = mul_columns_sse2;
+		kernels.div = div_columns_sse2;
+	}
+#endif
+
+	return kernels;
+}
+
+//An expression compiled to stack machine code. Running it only loops over the instructions, no text is read again.
+class ExpressionProgram{
+
+	private:
+
+	vector<Instruction> code;
+	vector<double> constants;
+	vector<double> values;
+	int depth;
+
+	void emit(OpCode op, int operand){
+		Instruction instruction;
+		instruction.op = op;
+		instruction.operand = operand;
+		code.push_back(instruction);
+	}
+
+	public:
+
+	ExpressionProgram(){
+		depth = 0;
+	}
+
+	void clear(void){
+		code.clear();
+		constants.clear();
+		values.clear();
+		depth = 0;
+	}
+
+	void push_const(double value){
+		constants.push_back(value);
+		emit(PUSH_CONST, constants.size() - 1);
+		depth++;
+		if(depth > (int) values.size()){
+			values.resize(depth);
+		}
+	}
+
+	void push_var(int slot){
+		emit(PUSH_VAR, slot);
+		depth++;
+		if(depth > (int) values.size()){
+			values.resize(depth);
+		}
+	}
+
+	void push_op(OpCode op){
+		emit(op, 0);
+		depth--;
+	}
+
+	int size(void){
+		return code.size();
+	}
+
+	//Returns 0 and sets result, or 1 on division by zero. variables holds the values of the PUSH_VAR slots.
+	int run(const double* variables, double &result){
+
+		const Instruction* instructions = code.data();
+		const double* constant_values = constants.data();
+		double* stack_values = values.data();
+		int instruction_count = code.size();
+		int top = -1;
+
+		for(int pc=0; pc<instruction_count; pc++){
+			switch(instructions[pc].op){
+				case PUSH_CONST:
+					stack_values[++top] = constant_values[instructions[pc].operand];
+					break;
+				case PUSH_VAR:
+					stack_values[++top] = variables[instructions[pc].operand];
+					break;
+				case ADD:
+					top--;
+					stack_values[top] += stack_values[top + 1];
+					break;
+				case SUB:
+					top--;
+					stack_values[top] -= stack_values[top + 1];
+					break;
+				case MUL:
+					top--;
+					stack_values[top] *= stack_values[top + 1];
+					break;
+				case DIV:
+					top--;
+					if(stack_values[top + 1] == 0){
+						return 1;
+					}
+					stack_values[top] /= stack_values[top + 1];
+					break;
+				case POW:
+					top--;
+					stack_values[top] = pow(stack_values[top], stack_values[top + 1]);
+					break;
+			}
+		}
+
+		result = stack_values[0];
+		return 0;
+	}
+
+	//Runs the program over row_count rows at once, a block of rows per instruction. columns[i] holds the values of
+	//variable slot i. A slot that only holds a variable points into its column instead of copying it.
+	int run_columns(const double* const* columns, int row_count, double* output, const ColumnKernels &kernels){
+
+		const int block_size = 1024;
+		int slot_count = values.size();
+		vector<double> buffers(slot_count * block_size);
+		vector<const double*> slots(slot_count);
+		const Instruction* instructions = code.data();
+		int instruction_count = code.size();
+
+		for(int start=0; start<row_count; start += block_size){
+			int n = min(block_size, row_count - start);
+			int top = -1;
+
+			for(int pc=0; pc<instruction_count; pc++){
+				OpCode op = instructions[pc].op;
+				if(op == PUSH_CONST){
+					top++;
+					double* buffer = &buffers[top * block_size];
+					fill(buffer, buffer + n, constants[instructions[pc].operand]);
+					slots[top] = buffer;
+				}
+				else if(op == PUSH_VAR){
+					top++;
+					slots[top] = columns[instructions[pc].operand] + start;
+				}
+				else {
+					top--;
+					double* buffer = &buffers[top * block_size];
+					if(op == ADD){
+						kernels.add(slots[top], slots[top + 1], buffer, n);
+					}
+					else if(op == SUB){
+						kernels.sub(slots[top], slots[top + 1], buffer, n);
+					}
+					else if(op == MUL){
+						kernels.mul(slots[top], slots[top + 1], buffer, n);
+					}
+					else if(op == DIV){
+						kernels.div(slots[top], slots[top + 1], buffer, n);
+					}
+					else if(op == POW){
+						kernels.pow(slots[top], slots[top + 1], buffer, n);
+					}
+					slots[top] = buffer;
+				}
+			}
+
+			copy(slots[0], slots[0] + n, output + start);
+		}
+
+		return 0;
+	}
+
+};
+
+//A signed integer of any size for exact evaluation. The magnitude is kept as base 2^32 limbs, least significant first,
+//with no leading zero limbs, so zero is an empty vector.
+class BigInteger{
+
+	private:
+
+	bool negative;
+	vector<uint32_t> limbs;
+
+	//Below this many limbs Karatsuba's extra additions cost more than the multiplications it saves
+	static const int karatsuba_threshold = 32;
+
+	static void trim(vector<uint32_t> &magnitude){
+		while(!magnitude.empty() && magnitude.back() == 0){
+			magnitude.pop_back();
+		}
+	}
+
+	static int compare_magnitudes(const vector<uint32_t> &a, const vector<uint32_t> &b){
+		if(a.size() != b.size()){
+			return a.size() < b.size() ? -1 : 1;
+		}
+		for(int i=a.size()-1; i>=0; i--){
+			if(a[i] != b[i]){
+				return a[i] < b[i] ? -1 : 1;
+			}
+		}
+		return 0;
+	}
+
+	static vector<uint32_t> add_magnitudes(const vector<uint32_t> &a, const vector<uint32_t> &b){
+		const vector<uint32_t> &longer = a.size() >= b.size() ? a : b;
+		const vector<uint32_t> &shorter = a.size() >= b.size() ? b : a;
+		vector<uint32_t> sum(longer.size() + 1);
+		uint64_t carry = 0;
+		for(int i=0; i<(int) longer.size(); i++){
+			carry += longer[i];
+			if(i < (int) shorter.size()){
+				carry += shorter[i];
+			}
+			sum[i] = (uint32_t) carry;
+			carry >>= 32;
+		}
+		sum[longer.size()] = (uint32_t) carry;
+		trim(sum);
+		return sum;
+	}
+
+	//a must not be smaller than b
+	static vector<uint32_t> subtract_magnitudes(const vector<uint32_t> &a, const vector<uint32_t> &b){
+		vector<uint32_t> difference(a.size());
+		int64_t borrow = 0;
+		for(int i=0; i<(int) a.size(); i++){
+			int64_t current = (int64_t) a[i] - borrow;
+			if(i < (int) b.size()){
+				current -= b[i];
+			}
+			borrow = current < 0 ? 1 : 0;
+			difference[i] = (uint32_t) current;
+		}
+		trim(difference);
+		return difference;
+	}
+
+	//Adds value shifted left by shift limbs into result, which must be long enough to hold the sum
+	static void add_shifted(vector<uint32_t> &result, const vector<uint32_t> &value, int shift){
+		uint64_t carry = 0;
+		int i = 0;
+		for(; i<(int) value.size(); i++){
+			carry += (uint64_t) result[i + shift] + value[i];
+			result[i + shift] = (uint32_t) carry;
+			carry >>= 32;
+		}
+		for(; carry != 0; i++){
+			carry += result[i + shift];
+			result[i + shift] = (uint32_t) carry;
+			carry >>= 32;
+		}
+	}
+
+	static vector<uint32_t> multiply_schoolbook(const vector<uint32_t> &a, const vector<uint32_t> &b){
+		if(a.empty() || b.empty()){
+			return vector<uint32_t>();
+		}
+		vector<uint32_t> product(a.size() + b.size());
+		for(int i=0; i<(int) a.size(); i++){
+			uint64_t carry = 0;
+			for(int j=0; j<(int) b.size(); j++){
+				carry += (uint64_t) a[i] * b[j] + product[i + j];
+				product[i + j] = (uint32_t) carry;
+				carry >>= 32;
+			}
+			product[i + b.size()] = (uint32_t) carry;
+		}
+		trim(product);
+		return product;
+	}
+
+	//Splits both numbers at half limbs into high * B + low and gets the product from three multiplications instead of
+	//four: low * low, high * high and (low + high) * (low + high), where the middle term is the last minus the first two.
+	static vector<uint32_t> multiply_karatsuba(const vector<uint32_t> &a, const vector<uint32_t> &b){
+		if(a.size() < karatsuba_threshold || b.size() < karatsuba_threshold){
+			return multiply_schoolbook(a, b);
+		}
+
+		int half = max(a.size(), b.size()) / 2;
+		vector<uint32_t> a_low(a.begin(), a.begin() + min<int>(half, a.size()));
+		vector<uint32_t> a_high(a.begin() + min<int>(half, a.size()), a.end());
+		vector<uint32_t> b_low(b.begin(), b.begin() + min<int>(half, b.size()));
+		vector<uint32_t> b_high(b.begin() + min<int>(half, b.size()), b.end());
+		trim(a_low);
+		trim(b_low);
+
+		vector<uint32_t> low = multiply_karatsuba(a_low, b_low);
+		vector<uint32_t> high = multiply_karatsuba(a_high, b_high);
+		vector<uint32_t> middle = multiply_karatsuba(add_magnitudes(a_low, a_high), add_magnitudes(b_low, b_high));
+		middle = subtract_magnitudes(subtract_magnitudes(middle, low), high);
+
+		vector<uint32_t> product(a.size() + b.size() + 1);
+		add_shifted(product, low, 0);
+		add_shifted(product, middle, half);
+		add_shifted(product, high, 2 * half);
+		trim(product);
+		return product;
+	}
+
+	//Divides magnitude in place by a single limb and returns the remainder
+	static uint32_t divide_small(vector<uint32_t> &magnitude, uint32_t divisor){
+		uint64_t remainder = 0;
+		for(int i=magnitude.size()-1; i>=0; i--){
+			uint64_t current = (remainder << 32) | magnitude[i];
+			magnitude[i] = (uint32_t) (current / divisor);
+			remainder = current % divisor;
+		}
+		trim(magnitude);
+		return (uint32_t) remainder;
+	}
+
+	//Long division in base 2^32 (Knuth's algorithm D). Both numbers are shifted so the divisor's top limb has its high
+	//bit set, which keeps each estimated quotient limb at most two above the real one. b must not be zero.
+	static void divide_magnitudes(const vector<uint32_t> &a, const vector<uint32_t> &b, vector<uint32_t> &quotient,
+			vector<uint32_t> &remainder){
+
+		if(compare_magnitudes(a, b) < 0){
+			quotient.clear();
+			remainder = a;
+			return;
+		}
+		if(b.size() == 1){
+			quotient = a;
+			uint32_t small_remainder = divide_small(quotient, b[0]);
+			remainder.clear();
+			if(small_remainder != 0){
+				remainder.push_back(small_remainder);
+			}
+			return;
+		}
+
+		int n = b.size();
+		int m = a.size() - n;
+		int shift = 0;
+		while((b[n - 1] << shift & 0x80000000u) == 0){
+			shift++;
+		}
+
+		vector<uint32_t> v(n), u(a.size() + 1);
+		for(int i=n-1; i>=0; i--){
+			v[i] = b[i] << shift;
+			if(shift != 0 && i > 0){
+				v[i] |= b[i - 1] >> (32 - shift);
+			}
+		}
+		u[a.size()] = shift != 0 ? a[a.size() - 1] >> (32 - shift) : 0;
+		for(int i=a.size()-1; i>=0; i--){
+			u[i] = a[i] << shift;
+			if(shift != 0 && i > 0){
+				u[i] |= a[i - 1] >> (32 - shift);
+			}
+		}
+
+		const uint64_t base = (uint64_t) 1 << 32;
+		quotient.assign(m + 1, 0);
+		for(int j=m; j>=0; j--){
+			uint64_t numerator = ((uint64_t) u[j + n] << 32) | u[j + n - 1];
+			uint64_t estimate = numerator / v[n - 1];
+			uint64_t rest = numerator % v[n - 1];
+			while(estimate >= base || estimate * v[n - 2] > ((rest << 32) | u[j + n - 2])){
+				estimate--;
+				rest += v[n - 1];
+				if(rest >= base){
+					break;
+				}
+			}
+
+			//u -= estimate * v at position j
+			int64_t borrow = 0;
+			uint64_t carry = 0;
+			for(int i=0; i<n; i++){
+				uint64_t product = estimate * v[i] + carry;
+				carry = product >> 32;
+				int64_t current = (int64_t) u[i + j] - borrow - (int64_t) (product & 0xffffffffu);
+				u[i + j] = (uint32_t) current;
+				borrow = current < 0 ? 1 : 0;
+			}
+			int64_t top = (int64_t) u[j + n] - borrow - (int64_t) carry;
+			u[j + n] = (uint32_t) top;
+
+			//The estimate was one too large: add v back once
+			if(top < 0){
+				estimate--;
+				uint64_t sum = 0;
+				for(int i=0; i<n; i++){
+					sum += (uint64_t) u[i + j] + v[i];
+					u[i + j] = (uint32_t) sum;
+					sum >>= 32;
+				}
+				u[j + n] += (uint32_t) sum;
+			}
+			quotient[j] = (uint32_t) estimate;
+		}
+
+		remainder.assign(n, 0);
+		for(int i=0; i<n; i++){
+			remainder[i] = u[i] >> shift;
+			if(shift != 0){
+				remainder[i] |= u[i + 1] << (32 - shift);
+			}
+		}
+		trim(quotient);
+		trim(remainder);
+	}
+
+	static BigInteger from_magnitude(const vector<uint32_t> &magnitude, bool negative){
+		BigInteger result;
+		result.limbs = magnitude;
+		result.negative = negative && !magnitude.empty();
+		return result;
+	}
+
+	public:
+
+	BigInteger(){
+		negative = false;
+	}
+
+	BigInteger(long long value){
+		negative = value < 0;
+		unsigned long long magnitude = negative ? 0ULL - (unsigned long long) value : (unsigned long long) value;
+		while(magnitude != 0){
+			limbs.push_back((uint32_t) magnitude);
+			magnitude >>= 32;
+		}
+	}
+
+	//Reads a run of decimal digits nine at a time. Returns -1 if anything else is in it.
+	int parse(const char* digits, int length){
+		negative = false;
+		limbs.clear();
+		if(length == 0){
+			return -1;
+		}
+		for(int i=0; i<length; i+=9){
+			int chunk_length = min(9, length - i);
+			uint32_t chunk = 0, scale = 1;
+			for(int k=i; k<i+chunk_length; k++){
+				if(digits[k] < '0' || digits[k] > '9'){
+					limbs.clear();
+					return -1;
+				}
+				chunk = chunk * 10 + (digits[k] - '0');
+				scale *= 10;
+			}
+			uint64_t carry = chunk;
+			for(int k=0; k<(int) limbs.size(); k++){
+				carry += (uint64_t) limbs[k] * scale;
+				limbs[k] = (uint32_t) carry;
+				carry >>= 32;
+			}
+			if(carry != 0){
+				limbs.push_back((uint32_t) carry);
+			}
+		}
+		trim(limbs);
+		return 0;
+	}
+
+	bool is_zero(void) const{
+		return limbs.empty();
+	}
+
+	bool is_negative(void) const{
+		return negative;
+	}
+
+	int limb_count(void) const{
+		return limbs.size();
+	}
+
+	bool equals(const BigInteger &other) const{
+		return negative == other.negative && limbs == other.limbs;
+	}
+
+	BigInteger add(const BigInteger &other) const{
+		if(negative == other.negative){
+			return from_magnitude(add_magnitudes(limbs, other.limbs), negative);
+		}
+		if(compare_magnitudes(limbs, other.limbs) >= 0){
+			return from_magnitude(subtract_magnitudes(limbs, other.limbs), negative);
+		}
+		return from_magnitude(subtract_magnitudes(other.limbs, limbs), other.negative);
+	}
+
+	BigInteger subtract(const BigInteger &other) const{
+		BigInteger negated = other;
+		negated.negative = !other.negative && !other.limbs.empty();
+		return add(negated);
+	}
+
+	BigInteger multiply(const BigInteger &other) const{
+		return from_magnitude(multiply_karatsuba(limbs, other.limbs), negative != other.negative);
+	}
+
+	//Same product as multiply() without Karatsuba, kept for ExpressionsTester to compare against
+	BigInteger multiply_schoolbook(const BigInteger &other) const{
+		return from_magnitude(multiply_schoolbook(limbs, other.limbs), negative != other.negative);
+	}
+
+	//Truncates toward zero like integer division in C++. Returns 1 on division by zero.
+	int divide(const BigInteger &other, BigInteger &quotient) const{
+		if(other.is_zero()){
+			return 1;
+		}
+		vector<uint32_t> quotient_limbs, remainder_limbs;
+		divide_magnitudes(limbs, other.limbs, quotient_limbs, remainder_limbs);
+		quotient = from_magnitude(quotient_limbs, negative != other.negative);
+		return 0;
+	}
+
+	//Exponentiation by squaring, so 2 ^ 4096 takes 12 squarings instead of 4095 multiplications. A negative exponent
+	//truncates 1 / (this ^ -exponent) toward zero. Returns 1 for 0 to a negative power and 2 if the exponent does not
+	//fit in 32 bits while the result would not be 0, 1 or -1.
+	int power(const BigInteger &exponent, BigInteger &result) const{
+		bool unit = limbs.size() == 1 && limbs[0] == 1;
+		bool odd = !exponent.limbs.empty() && (exponent.limbs[0] & 1) != 0;
+
+		if(exponent.negative){
+			if(is_zero()){
+				return 1;
+			}
+			result = BigInteger(unit ? 1 : 0);
+			result.negative = unit && negative && odd;
+			return 0;
+		}
+		if(is_zero() || unit){
+			result = BigInteger(exponent.is_zero() ? 1 : (is_zero() ? 0 : 1));
+			result.negative = unit && negative && odd;
+			return 0;
+		}
+		if(exponent.limbs.size() > 1){
+			return 2;
+		}
+
+		uint32_t remaining = exponent.is_zero() ? 0 : exponent.limbs[0];
+		BigInteger base = *this;
+		result = BigInteger(1);
+		while(remaining != 0){
+			if(remaining & 1){
+				result = result.multiply(base);
+			}
+			remaining >>= 1;
+			if(remaining != 0){
+				base = base.multiply(base);
+			}
+		}
+		return 0;
+	}
+
+	//Peels off nine decimal digits at a time with divide_small
+	string to_decimal(void) const{
+		if(limbs.empty()){
+			return "0";
+		}
+		vector<uint32_t> magnitude = limbs;
+		vector<uint32_t> chunks;
+		while(!magnitude.empty()){
+			chunks.push_back(divide_small(magnitude, 1000000000u));
+		}
+
+		string digits = negative ? "-" : "";
+		digits += std::to_string(chunks.back());
+		for(int i=chunks.size()-2; i>=0; i--){
+			string chunk = std::to_string(chunks[i]);
+			digits.append(9 - chunk.length(), '0');
+			digits += chunk;
+		}
+		return digits;
+	}
+
+};
+
+//Reads a number literal in place with from_chars: no temporary string, no locale and no allocation. A literal out
+//of range is read again with strtod, which gives HUGE_VAL for one too large and 0 for one too small, whether it is
+//small through a negative exponent or through a long run of zeros after the point.
+double parse_number(const char* start, const char* end){
+	double value = 0;
+	from_chars_result result = from_chars(start, end, value);
+	if(result.ec == errc::result_out_of_range){
+		string literal(start, end);
+		value = strtod(literal.c_str(), NULL);
+	}
+	return value;
+}
+
+//Applies one operator for the evaluators that work on plain doubles. Division by zero only sets the flag, so a scan
+//can go on and still report letters, which take precedence as in the compiled path.
+double apply_operator(TokenType op, double left, double right, bool &divided_by_zero){
+	if(op == ADD_OP){
+		return left + right;
+	}
+	else if(op == SUB_OP){
+		return left - right;
+	}
+	else if(op == MULT_OP){
+		return left * right;
+	}
+	else if(op == DIV_OP){
+		if(right == 0){
+			divided_by_zero = true;
+		}
+		return left / right;
+	}
+	return pow(left, right);
+}
+
+class Expression{
+
+
+	private:
+
+		string_view expression;		//the text, either owned_expression or bytes the caller keeps alive
+		string owned_expression;
+		vector<Token> tokens;
+		ExpressionType type;
+		string separator;
+
+		ExpressionArena nodes;
+		int root;
+		int max_depth;		//deepest nesting accepted, as ExpressionParser::set_max_depth sets for the parsers
+
+		ExpressionProgram program;
+		bool compiled;
+		bool has_variables;
+		SymbolTable own_symbols;
+
+		void evaluate_type(void){
+
+			//Malformed input is common, and most of it is thrown out here without lexing
+			ExpressionScreen screen(expression);
+			if(screen.rejects()){
+				Token end;
+				end.type = END;
+				end.offset = 0;
+				end.length = 0;
+				tokens.assign(1, end);
+				type = ERROR_EXPR;
+			} else {
+				ExpressionLexer lexer(expression);
+				lexer.tokenize(tokens);
+
+				//Infix and postfix expressions are checked and built in the same pass. Prefix and postfix ones fail
+				//parse_infix within their first two tokens, and only a postfix expression starts with an operand
+				//after that, so only the prefix grammar is left to check.
+				root = parse_infix();
+				if(root != -1){
+					type = INFIX;
+				}
+				else if(is_operand(tokens[0].type) && (root = parse_postfix()) != -1){
+					type = POSTFIX;
+				} else {
+					ExpressionClassifier classifier(tokens);
+					classifier.set_max_depth(max_depth);
+					type = classifier.classify_prefix();
+				}
+			}
+
+			//Converted forms keep the spacing of the input, so "5 10 +" does not turn into "510+"
+			if(expression.find(' ') != string::npos){
+				separator = " ";
+			} else {
+				separator = "";
+			}
+
+		}
+
+		int get_priority(TokenType token_type){
+			return token_type_table.priority[token_type];
+		}
+
+		bool is_operator(TokenType token_type){
+			return token_type_table.is_operator[token_type];
+		}
+
+		bool is_operand(TokenType token_type){
+			return token_type_table.is_operand[token_type];
+		}
+
+		//Copies a token from the expression straight into the output instead of through a temporary string
+		void append_token(string &output, const Token &token){
+			if(!output.empty()){
+				output += separator;
+			}
+			output.append(expression, token.offset, token.length);
+		}
+
+		double number_value(const Token &token){
+			const char* start = expression.data() + token.offset;
+			return parse_number(start, start + token.length);
+		}
+
+		int add_node(const Token &token, int left, int right){
+			return nodes.allocate(token, left, right, get_priority(token.type));
+		}
+
+		//Folds the operators on top of frames that bind at least as tight as binding_power into left. Folding on equal
+		//power keeps every operator left associative, as the shunting-yard loop did.
+		int fold(vector<InfixFrame> &frames, int left, int binding_power){
+			while(!frames.empty() && get_priority(tokens[frames.back().op].type) >= binding_power){
+				InfixFrame &frame = frames.back();
+				left = add_node(tokens[frame.op], frame.left, left);
+				frames.pop_back();
+			}
+			return left;
+		}
+
+		//Precedence climbing over the tokens, with the binding power of each operator from get_priority: + - bind at 1,
+		//* / at 2 and ^ at 3. Checks the <expr>/<term>/<factor> grammar and builds the tree in one pass, keeping the
+		//pending operators on an explicit stack instead of the call stack. Returns the root, or -1 when the tokens
+		//are not an infix expression.
+		int parse_infix(void){
+
+			static thread_local vector<InfixFrame> frames;
+			InfixFrame frame;
+			int left = -1;
+			int par_depth = 0;
+			bool expecting_operand = true;
+
+			frames.clear();
+			nodes.reset(tokens.size());
+			for(int i=0; ; i++){
+				TokenType token_type = tokens[i].type;
+
+				if(expecting_operand){
+					if(is_operand(token_type)){
+						left = add_node(tokens[i], -1, -1);
+						expecting_operand = false;
+					}
+					else if(token_type == L_PAR && par_depth < max_depth){
+						frame.left = -1;
+						frame.op = i;
+						frames.push_back(frame);
+						par_depth++;
+					} else {
+						return -1;
+					}
+					continue;
+				}
+
+				if(is_operator(token_type)){
+					frame.left = fold(frames, left, get_priority(token_type));
+					frame.op = i;
+					frames.push_back(frame);
+					expecting_operand = true;
+				}
+				else if(token_type == R_PAR){
+					left = fold(frames, left, 1);
+					if(frames.empty()){
+						return -1;
+					}
+					frames.pop_back();
+					par_depth--;
+				}
+				else if(token_type == END){
+					left = fold(frames, left, 1);
+					if(!frames.empty()){
+						return -1;
+					}
+					return left;
+				} else {
+					return -1;
+				}
+			}
+		}
+
+		//Checks a postfix expression with the operand stack the validator keeps anyway and builds the tree on it, so
+		//the input is read once. Returns the root, or -1 when the tokens are not a postfix expression.
+		int parse_postfix(void){
+
+			static thread_local vector<int> operands;
+
+			operands.clear();
+			nodes.reset(tokens.size());
+			for(int i=0; tokens[i].type != END; i++){
+				if(is_operand(tokens[i].type) && operands.size() <= (size_t) max_depth){
+					operands.push_back(add_node(tokens[i], -1, -1));
+				}
+				else if(is_operator(tokens[i].type) && operands.size() >= 2){
+					int right = operands.back();
+					operands.pop_back();
+					operands.back() = add_node(tokens[i], operands.back(), right);
+				} else {
+					return -1;
+				}
+			}
+			if(operands.size() != 1){
+				return -1;
+			}
+			return operands.back();
+		}
+
+		//Builds the tree of a prefix expression once. Infix and postfix trees come from parse_infix and parse_postfix.
+		//Every conversion reads the tree afterwards.
+		void build_tree(void){
+
+			if(root != -1 || type == ERROR_EXPR){
+				return;
+			}
+
+			static thread_local vector<int> operands;
+			//every node comes from one token, so this is the only allocation the tree needs
+			nodes.reset(tokens.size());
+
+			operands.clear();
+			if(type == PREFIX){
+				for(int i=tokens.size()-2; i>=0; i--){
+					if(is_operand(tokens[i].type)){
+						operands.push_back(add_node(tokens[i], -1, -1));
+					} else {
+						int left = operands.back();
+						operands.pop_back();
+						operands.back() = add_node(tokens[i], left, operands.back());
+					}
+				}
+			}
+
+			root = operands.back();
+		}
+
+		//A child is wrapped only when it binds looser than its parent, or just as tight on the right (a-(b-c)).
+		bool needs_parentheses(int child, int parent, bool is_right){
+			if(nodes[child].left == -1){
+				return false;
+			}
+			if(nodes[child].priority < nodes[parent].priority){
+				return true;
+			}
+			if(is_right && nodes[child].priority == nodes[parent].priority){
+				return true;
+			}
+			return false;
+		}
+
+		//Node indices in postfix order. The tree is walked with a stack so deep expressions do not overflow the call stack.
+		vector<int> postfix_order(){
+
+			vector<int> order;
+			stack<int> pending;
+
+			order.reserve(nodes.size());
+			pending.push(root);
+			while(!pending.empty()){
+				int current = pending.top();
+				pending.pop();
+				order.push_back(current);
+				if(nodes[current].left != -1){
+					pending.push(nodes[current].left);
+					pending.push(nodes[current].right);
+				}
+			}
+			reverse(order.begin(), order.end());
+
+			return order;
+		}
+
+		//Appends the prefix form to output: the tree in pre-order, written once into space sized up front
+		void emit_prefix(string &output){
+
+			static thread_local vector<int> pending;
+
+			build_tree();
+			int start = output.length();
+			output.resize(start + tree_text_length());
+			char* out = &output[start];
+
+			pending.clear();
+			pending.push_back(root);
+			while(!pending.empty()){
+				int current = pending.back();
+				pending.pop_back();
+				out = write_token(out, nodes[current].token);
+				if(nodes[current].left != -1){
+					pending.push_back(nodes[current].right);
+					pending.push_back(nodes[current].left);
+				}
+			}
+			output.resize(output.length() - separator.length());
+		}
+
+		//Appends the postfix form to output. Postfix is the pre-order that visits the right operand first, reversed,
+		//so that walk fills the presized space from its end and no order has to be kept or reversed.
+		void emit_postfix(string &output){
+
+			static thread_local vector<int> pending;
+
+			build_tree();
+			int start = output.length();
+			output.resize(start + tree_text_length());
+			char* out = &output[0] + output.length();
+
+			pending.clear();
+			pending.push_back(root);
+			while(!pending.empty()){
+				int current = pending.back();
+				pending.pop_back();
+				out = write_token_backwards(out, nodes[current].token);
+				if(nodes[current].left != -1){
+					pending.push_back(nodes[current].left);
+					pending.push_back(nodes[current].right);
+				}
+			}
+			output.resize(output.length() - separator.length());
+		}
+
+		//Length of every token of the tree, each followed by the separator. This is the length of its prefix and
+		//postfix forms with one separator too many at the end.
+		int tree_text_length(){
+			int length = 0;
+			//every node of the arena belongs to the tree
+			for(int i=0; i<nodes.size(); i++){
+				length += nodes[i].token.length;
+			}
+			return length + nodes.size() * separator.length();
+		}
+
+		//Length of the infix form: every token plus a pair of parentheses for each child that needs them, each followed
+		//by the separator
+		int infix_length(){
+
+			int length = tree_text_length();
+
+			for(int i=0; i<nodes.size(); i++){
+				if(nodes[i].left != -1){
+					if(needs_parentheses(nodes[i].left, i, false)){
+						length += 2 * (1 + separator.length());
+					}
+					if(needs_parentheses(nodes[i].right, i, true)){
+						length += 2 * (1 + separator.length());
+					}
+				}
+			}
+
+			return length;
+		}
+
+		//Copies a token and the separator after it into an output buffer at out and returns the position after them
+		char* write_token(char* out, const Token &token){
+			memcpy(out, expression.data() + token.offset, token.length);
+			out += token.length;
+			memcpy(out, separator.data(), separator.length());
+			return out + separator.length();
+		}
+
+		//Copies a token and the separator after it into an output buffer so they end at end and returns where the
+		//token starts
+		char* write_token_backwards(char* end, const Token &token){
+			end -= separator.length();
+			memcpy(end, separator.data(), separator.length());
+			end -= token.length;
+			memcpy(end, expression.data() + token.offset, token.length);
+			return end;
+		}
+
+		char* write_parenthesis(char* out, char parenthesis){
+			*out = parenthesis;
+			memcpy(out + 1, separator.data(), separator.length());
+			return out + 1 + separator.length();
+		}
+
+		//Appends the infix form to output. The tree already knows the priority of every sub-expression, so each
+		//parenthesis is decided in constant time, and the text is written once into space sized up front: linear
+		//however deep the expression is.
+		void emit_infix(string &output){
+
+			static thread_local vector<EmitFrame> frames;
+			EmitFrame frame;
+
+			build_tree();
+			int start = output.length();
+			output.resize(start + infix_length());
+			char* out = &output[start];
+
+			frames.clear();
+			frame.node = root;
+			frame.stage = 0;
+			frame.parenthesized = false;
+			frames.push_back(frame);
+
+			while(!frames.empty()){
+				EmitFrame current = frames.back();
+				frames.pop_back();
+				ExpressionNode &node = nodes[current.node];
+
+				if(node.left == -1){
+					out = write_token(out, node.token);
+					continue;
+				}
+
+				//stage 0: opening parenthesis and left operand, 1: operator and right operand, 2: closing parenthesis
+				if(current.stage == 0){
+					if(current.parenthesized){
+						out = write_parenthesis(out, '(');
+					}
+					current.stage = 1;
+					frames.push_back(current);
+					frame.node = node.left;
+					frame.parenthesized = needs_parentheses(node.left, current.node, false);
+					frames.push_back(frame);
+				}
+				else if(current.stage == 1){
+					out = write_token(out, node.token);
+					current.stage = 2;
+					frames.push_back(current);
+					frame.node = node.right;
+					frame.parenthesized = needs_parentheses(node.right, current.node, true);
+					frames.push_back(frame);
+				}
+				else if(current.parenthesized){
+					out = write_parenthesis(out, ')');
+				}
+			}
+			//the last item needs no separator after it
+			output.resize(output.length() - separator.length());
+		}
+
+	public:
+
+
+		//max_depth bounds nesting the way it does for the parsers, and an input past it is an ERROR
+		Expression(string input, int init_max_depth = ExpressionParser::default_max_depth){
+			owned_expression.swap(input);
+			expression = owned_expression;
+			root = -1;
+			max_depth = init_max_depth;
+			compiled = false;
+			has_variables = false;
+			this->evaluate_type();
+		}
+
+		Expression(const char* input, int init_max_depth = ExpressionParser::default_max_depth) : Expression(string(input), init_max_depth){
+		}
+
+		//Reads the text in place without copying it, for lines of a mapped file. The bytes must outlive the Expression.
+		Expression(string_view input, int init_max_depth = ExpressionParser::default_max_depth){
+			expression = input;
+			root = -1;
+			max_depth = init_max_depth;
+			compiled = false;
+			has_variables = false;
+			this->evaluate_type();
+		}
+
+		//A copy of an Expression that owns its text gets its own copy of the text, so it never points into the original
+		Expression(const Expression &other) : Expression(other.expression, other.max_depth){
+			if(other.expression.data() == other.owned_expression.data()){
+				owned_expression = other.owned_expression;
+				expression = owned_expression;
+			}
+		}
+
+		Expression& operator=(const Expression &other) = delete;
+
+		//Finds the notation of input without building an Expression. The token buffer is kept between calls on the
+		//same thread, so once it has grown to fit the longest input nothing is allocated.
+		static ExpressionType classify(string_view input){
+			static thread_local vector<Token> scratch;
+			ExpressionScreen screen(input);
+			if(screen.rejects()){
+				return ERROR_EXPR;
+			}
+			ExpressionLexer lexer(input);
+			lexer.tokenize(scratch);
+			ExpressionClassifier classifier(scratch);
+			return classifier.classify();
+		}
+
+		ExpressionType get_type(void){
+			return type;
+		}
+
+		string infix_to_prefix(){
+
+			if(type != INFIX){
+				return "error";
+			}
+
+			string prefix = "";
+			emit_prefix(prefix);
+			return prefix;
+		}
+
+		string infix_to_postfix(){
+
+			if(type != INFIX){
+				return "error";
+			}
+
+			string postfix = "";
+			emit_postfix(postfix);
+			return postfix;
+		}
+
+		string prefix_to_infix(){
+
+			if(type != PREFIX){
+				return "error";
+			}
+
+			string infix = "";
+			emit_infix(infix);
+			return infix;
+		}
+
+		string prefix_to_postfix(){
+
+			if(type != PREFIX){
+				return "error";
+			}
+
+			string postfix = "";
+			emit_postfix(postfix);
+			return postfix;
+		}
+
+		string postfix_to_infix(){
+
+			if(type != POSTFIX){
+				return "error";
+			}
+
+			string infix = "";
+			emit_infix(infix);
+			return infix;
+		}
+
+		string postfix_to_prefix(){
+
+			if(type != POSTFIX){
+				return "error";
+			}
+
+			string prefix = "";
+			emit_prefix(prefix);
+			return prefix;
+		}
+		
+		int get_equivalents(){
+			
+			cout << "Getting Equivalent Form of Expression Input" << '\n';
+			cout << "-------------------------------------------" << '\n';
+
+			cout << "Expression:\t" << expression << '\n';
+			cout << "Type: ";
+			if(type == INFIX){
+				cout << "\t\tINFIX" << '\n';
+				cout << "Prefix:\t\t" << infix_to_prefix() << '\n';
+				cout << "Postfix:\t" << infix_to_postfix() << '\n';
+			} else if(type == PREFIX){
+				cout << "\t\tPREFIX" << '\n';
+				cout << "Infix:\t\t" << prefix_to_infix() << '\n';
+				cout << "Postfix:\t" << prefix_to_postfix() << '\n';
+			} else if(type == POSTFIX){
+				cout << "\t\tPOSTFIX" << '\n';
+				cout << "Infix:\t\t" << postfix_to_infix() << '\n';
+				cout << "Prefix:\t\t" << postfix_to_prefix() << '\n';
+			} else {
+				cout << "\t\tERROR_EXPR" << '\n';
+			}
+
+			return 0;
+		}
+
+		//One line of batch output: the type and the other two notations, separated by tabs
+		void append_equivalents(string &output){
+			if(type == INFIX){
+				output += "INFIX\t";
+				emit_prefix(output);
+				output += '\t';
+				emit_postfix(output);
+			} else if(type == PREFIX){
+				output += "PREFIX\t";
+				emit_infix(output);
+				output += '\t';
+				emit_postfix(output);
+			} else if(type == POSTFIX){
+				output += "POSTFIX\t";
+				emit_infix(output);
+				output += '\t';
+				emit_prefix(output);
+			} else {
+				output += "ERROR_EXPR";
+			}
+		}
+
+		//Folds the operator on top of operators into the two values on top of values
+		void reduce_values(vector<double> &values, vector<TokenType> &operators, bool &divided_by_zero){
+			double right = values.back();
+			values.pop_back();
+			values.back() = apply_operator(operators.back(), values.back(), right, divided_by_zero);
+			operators.pop_back();
+		}
+
+		//Evaluates straight from the tokens on a stack of doubles, without the tree or a compiled program: prefix right to
+		//left, postfix left to right and infix with an operand and an operator stack, reducing while the operator on top
+		//binds at least as tight, as parse_infix does. Returns 0 and sets answer, 1 on division by zero, 2 if the
+		//expression has letters and -1 if it is erroneous.
+		int evaluate_direct(double &answer){
+
+			static thread_local vector<double> values;
+			static thread_local vector<TokenType> operators;
+			bool divided_by_zero = false, has_letters = false;
+			int token_count = tokens.size() - 1;
+
+			if(type == ERROR_EXPR){
+				return -1;
+			}
+
+			values.clear();
+			operators.clear();
+			for(int k=0; k<token_count; k++){
+				//prefix is read from its last token
+				int i = k;
+				if(type == PREFIX){
+					i = token_count - 1 - k;
+				}
+				TokenType token_type = tokens[i].type;
+
+				if(token_type == DIGIT){
+					values.push_back(number_value(tokens[i]));
+				}
+				else if(token_type == LETTER){
+					values.push_back(0);
+					has_letters = true;
+				}
+				else if(type == PREFIX){
+					double left = values.back();
+					values.pop_back();
+					values.back() = apply_operator(token_type, left, values.back(), divided_by_zero);
+				}
+				else if(type == POSTFIX){
+					double right = values.back();
+					values.pop_back();
+					values.back() = apply_operator(token_type, values.back(), right, divided_by_zero);
+				}
+				else if(token_type == L_PAR){
+					operators.push_back(token_type);
+				}
+				else if(token_type == R_PAR){
+					while(operators.back() != L_PAR){
+						reduce_values(values, operators, divided_by_zero);
+					}
+					operators.pop_back();
+				} else {
+					while(!operators.empty() && get_priority(operators.back()) >= get_priority(token_type)){
+						reduce_values(values, operators, divided_by_zero);
+					}
+					operators.push_back(token_type);
+				}
+			}
+			while(!operators.empty()){
+				reduce_values(values, operators, divided_by_zero);
+			}
+
+			if(has_letters){
+				return 2;
+			}
+			if(divided_by_zero){
+				return 1;
+			}
+			answer = values.back();
+			return 0;
+		}
+
+		//Compiles the tree to stack machine code. A letter reads the row position symbols gives it. Letters missing
+		//from symbols are added when add_missing is set and are an error otherwise, with the first one left in
+		//undefined_name for the caller to report.
+		int compile_program(SymbolTable &symbols, bool add_missing, string &undefined_name){
+
+			if(type == ERROR_EXPR){
+				return -1;
+			}
+
+			build_tree();
+			vector<int> postfix = postfix_order();
+
+			compiled = false;
+			has_variables = false;
+			program.clear();
+			for(int i=0; i<(int) postfix.size(); i++){
+				const Token &token = nodes[postfix.at(i)].token;
+				if(token.type == DIGIT){
+					program.push_const(number_value(token));
+				}
+				else if(token.type == LETTER){
+					string name(expression.substr(token.offset, token.length));
+					int column = symbols.find(name);
+					if(column == -1 && add_missing){
+						column = symbols.add(name);
+					}
+					else if(column == -1){
+						undefined_name = name;
+						return -1;
+					}
+					program.push_var(column);
+					has_variables = true;
+				}
+				else if(token.type == ADD_OP){
+					program.push_op(ADD);
+				}
+				else if(token.type == SUB_OP){
+					program.push_op(SUB);
+				}
+				else if(token.type == MULT_OP){
+					program.push_op(MUL);
+				}
+				else if(token.type == DIV_OP){
+					program.push_op(DIV);
+				}
+				else if(token.type == EXP_OP){
+					program.push_op(POW);
+				}
+			}
+
+			compiled = true;
+			return 0;
+		}
+
+		//Compiles once; later calls reuse the program. Letters get row positions in order of first appearance.
+		int compile(void){
+			if(compiled){
+				return 0;
+			}
+			string undefined_name;
+			return compile_program(own_symbols, true, undefined_name);
+		}
+
+		//Compiles against the caller's symbols so that the same row layout can be shared by many expressions. Returns -1
+		//if the expression is erroneous or has a letter symbols does not know, which is then put in undefined_name.
+		int compile(SymbolTable &symbols, string &undefined_name){
+			return compile_program(symbols, false, undefined_name);
+		}
+
+		int compile(SymbolTable &symbols){
+			string undefined_name;
+			return compile(symbols, undefined_name);
+		}
+
+		//Runs the compiled program with variables read from row. This is the call to make once per record.
+		int evaluate(const double* row, double &answer){
+
+			if(!compiled){
+				return -1;
+			}
+			if(program.run(row, answer) != 0){
+				return -1;
+			}
+
+			return 0;
+		}
+
+		//Evaluates the compiled expression for row_count rows in one call. columns[i] holds the values of the variable at
+		//position i of the symbol table. Division by zero gives inf or nan in that row instead of failing the whole batch.
+		int evaluate_columns(const double* const* columns, int row_count, double* output, const ColumnKernels &kernels){
+
+			if(!compiled){
+				return -1;
+			}
+
+			return program.run_columns(columns, row_count, output, kernels);
+		}
+
+		int evaluate_columns(const double* const* columns, int row_count, double* output){
+			static ColumnKernels best_kernels = get_column_kernels("");
+			return evaluate_columns(columns, row_count, output, best_kernels);
+		}
+
+		//Same as evaluate() without printing. Returns 0 and sets answer, or -1 if the expression cannot be evaluated.
+		//A compiled expression reruns its program. Otherwise the tokens are evaluated directly, since building a tree and a
+		//program only pays off when they are run more than once.
+		int evaluate(double &answer){
+
+			if(compiled){
+				if(has_variables || program.run(NULL, answer) != 0){
+					return -1;
+				}
+				return 0;
+			}
+			if(evaluate_direct(answer) != 0){
+				return -1;
+			}
+
+			return 0;
+		}
+
+		int evaluate(void){
+			
+			if(type == ERROR_EXPR){
+				cout << "ERRONEOUS EXPRESSION. CANNOT EVALUATE" << endl;
+				return -1;
+			}
+
+			double answer;
+			int status = evaluate_direct(answer);
+			if(status == 2){
+				cout << "NON NUMERIC EXPRESSION. CANNOT EVALUATE" << endl;
+				return -1;
+			}
+			if(status == 1){
+				cout << "Division by Zero Error" << endl;
+				return -1;
+			}
+
+			//15 significant digits, so whole numbers up to 10^15 print exactly instead of as 1e+09
+			streamsize precision = cout.precision(15);
+			cout << "Expression:\t" << expression << endl;
+			cout << "Answer:\t" << answer << endl;
+			cout.precision(precision);
+			
+
+			return 0;
+		}
+
+		//Evaluates with BigInteger instead of double, so no digit is lost however large the numbers get. Returns 0 and
+		//sets answer, 1 on division by zero, 2 for an exponent too large to compute, 3 if the expression has letters or
+		//numbers that are not whole and -1 if it is erroneous.
+		int evaluate_integer(BigInteger &answer){
+
+			if(type == ERROR_EXPR){
+				return -1;
+			}
+
+			build_tree();
+			vector<int> postfix = postfix_order();
+
+			vector<BigInteger> values;
+			for(int i=0; i<(int) postfix.size(); i++){
+				const Token &token = nodes[postfix.at(i)].token;
+				if(token.type == DIGIT){
+					values.push_back(BigInteger());
+					if(values.back().parse(expression.data() + token.offset, token.length) != 0){
+						return 3;
+					}
+					continue;
+				}
+				if(token.type == LETTER){
+					return 3;
+				}
+
+				BigInteger right = values.back();
+				values.pop_back();
+				BigInteger &left = values.back();
+				BigInteger result;
+				int status = 0;
+				if(token.type == ADD_OP){
+					result = left.add(right);
+				}
+				else if(token.type == SUB_OP){
+					result = left.subtract(right);
+				}
+				else if(token.type == MULT_OP){
+					result = left.multiply(right);
+				}
+				else if(token.type == DIV_OP){
+					status = left.divide(right, result);
+				}
+				else if(token.type == EXP_OP){
+					status = left.power(right, result);
+				}
+				if(status != 0){
+					return status;
+				}
+				left = result;
+			}
+
+			answer = values.back();
+			return 0;
+		}
+
+		int evaluate_integer(void){
+
+			if(type == ERROR_EXPR){
+				cout << "ERRONEOUS EXPRESSION. CANNOT EVALUATE" << endl;
+				return -1;
+			}
+
+			BigInteger answer;
+			int status = evaluate_integer(answer);
+			if(status == 1){
+				cout << "Division by Zero Error" << endl;
+				return -1;
+			}
+			else if(status == 2){
+				cout << "EXPONENT TOO LARGE. CANNOT EVALUATE" << endl;
+				return -1;
+			}
+			else if(status == 3){
+				cout << "NON INTEGER EXPRESSION. CANNOT EVALUATE" << endl;
+				return -1;
+			}
+
+			cout << "Expression:\t" << expression << endl;
+			cout << "Answer:\t" << answer.to_decimal() << endl;
+
+			return 0;
+		}
+		
+
+};
+
+//An operator of a prefix stream still waiting for one or both of its operands
+struct PendingOperator{
+
+	TokenType op;
+	bool has_left;
+	double left;
+
+};
+
+//Evaluates a postfix or prefix expression handed over in chunks of any size, for streams too long to hold as one
+//string. Only the operand stack (postfix) or the operators still waiting for operands (prefix) are kept, plus the
+//characters of a number split between two chunks. A postfix operator needs two operands on the stack, as in
+//PostfixExpressionParser. Line breaks count as spaces, so a stream may be written line by line.
+class StreamingEvaluator{
+
+	private:
+
+	ExpressionType notation;
+	vector<double> values;				//postfix: the operand stack
+	vector<PendingOperator> pending;	//prefix: operators still waiting for an operand
+	string number;
+	NumberState number_state;
+	double result;						//prefix: the answer, once complete
+	bool complete;
+	bool valid;
+	bool divided_by_zero;
+
+	//Adds c to the number being read if it can extend it
+	bool continue_number(char c){
+		NumberState next = next_number_state(number_state, c);
+
+		if(next == NOT_IN_NUMBER){
+			return false;
+		}
+		number += c;
+		number_state = next;
+		return true;
+	}
+
+	//A number cut off after its point or exponent mark leaves a '.' or a letter behind, which no expression to
+	//evaluate can have
+	void end_number(void){
+		if(number_state == DECIMAL_POINT || number_state == EXPONENT_MARK || number_state == EXPONENT_SIGN){
+			valid = false;
+		} else {
+			push_value(parse_number(number.data(), number.data() + number.length()));
+		}
+		number.clear();
+		number_state = NOT_IN_NUMBER;
+	}
+
+	void push_value(double value){
+		if(notation == POSTFIX){
+			values.push_back(value);
+			return;
+		}
+		if(complete){
+			valid = false;
+			return;
+		}
+		//the value fills the innermost waiting operator; an operator that gets its right operand is itself a value
+		while(!pending.empty()){
+			PendingOperator &top = pending.back();
+			if(!top.has_left){
+				top.left = value;
+				top.has_left = true;
+				return;
+			}
+			value = apply_operator(top.op, top.left, value, divided_by_zero);
+			pending.pop_back();
+		}
+		result = value;
+		complete = true;
+	}
+
+	void push_operator(TokenType op){
+		if(notation == POSTFIX){
+			if(values.size() < 2){
+				valid = false;
+				return;
+			}
+			double right = values.back();
+			values.pop_back();
+			values.back() = apply_operator(op, values.back(), right, divided_by_zero);
+			return;
+		}
+		if(complete){
+			valid = false;
+			return;
+		}
+		PendingOperator waiting;
+		waiting.op = op;
+		waiting.has_left = false;
+		waiting.left = 0;
+		pending.push_back(waiting);
+	}
+
+	public:
+
+	//notation is POSTFIX or PREFIX
+	StreamingEvaluator(ExpressionType init_notation){
+		notation = init_notation;
+		reset();
+	}
+
+	void reset(void){
+		values.clear();
+		pending.clear();
+		number.clear();
+		number_state = NOT_IN_NUMBER;
+		result = 0;
+		complete = false;
+		valid = notation == POSTFIX || notation == PREFIX;
+		divided_by_zero = false;
+	}
+
+	//Reads the next chunk. Returns 0, or -1 once the stream can no longer be a valid expression.
+	int feed(string_view chunk){
+		for(size_t i=0; i<chunk.length() && valid; i++){
+			char c = chunk[i];
+			if(number_state != NOT_IN_NUMBER){
+				if(continue_number(c)){
+					continue;
+				}
+				end_number();
+				if(!valid){
+					break;
+				}
+			}
+
+			TokenType type = char_token_type(c);
+			if(type == DIGIT){
+				number += c;
+				number_state = INTEGER_PART;
+			}
+			else if(token_type_table.is_operator[type]){
+				push_operator(type);
+			}
+			else if(type != SPACE && c != '\n' && c != '\r'){
+				valid = false;
+			}
+		}
+
+		if(!valid){
+			return -1;
+		}
+		return 0;
+	}
+
+	//Ends the stream. Returns 0 and sets answer, 1 on division by zero and -1 if the stream was not a valid expression.
+	int finish(double &answer){
+		if(number_state != NOT_IN_NUMBER && valid){
+			end_number();
+		}
+		if(!valid){
+			return -1;
+		}
+		if(notation == POSTFIX && values.size() != 1){
+			return -1;
+		}
+		if(notation == PREFIX && !complete){
+			return -1;
+		}
+		if(divided_by_zero){
+			return 1;
+		}
+		if(notation == POSTFIX){
+			answer = values.back();
+		} else {
+			answer = result;
+		}
+		return 0;
+	}
+
+	//Operands on the stack for postfix, or operators waiting for operands for prefix: all the memory the stream holds
+	int depth(void){
+		if(notation == POSTFIX){
+			return values.size();
+		}
+		return pending.size();
+	}
+
+};
+
+//Evaluates one postfix or prefix expression read from input in blocks of buffer_size bytes and writes the answer, or
+//ERROR. The expression may be far larger than memory.
+int process_stream(istream &input, ostream &output, int buffer_size, ExpressionType notation){
+
+	vector<char> buffer(buffer_size);
+	StreamingEvaluator evaluator(notation);
+	double answer;
+
+	while(input){
+		input.read(buffer.data(), buffer_size);
+		if(evaluator.feed(string_view(buffer.data(), input.gcount())) != 0){
+			break;
+		}
+	}
+	if(evaluator.finish(answer) == 0){
+		char text[32];
+		snprintf(text, sizeof(text), "%.15g", answer);
+		output << text << '\n';
+		return 0;
+	}
+	output << "ERROR" << '\n';
+	return 1;
+}
+
+//Converts an infix expression handed over in chunks of any size to postfix, writing each part of the output as soon
+//as the shunting-yard loop produces it. Memory is the operator stack, so it grows with the nesting of the expression
+//and not with its length. Numbers follow the literal grammar of the lexer across chunk boundaries. The converter
+//cannot look ahead for spaces, so the postfix tokens are always separated by one, and line breaks count as spaces.
+class StreamingInfixConverter{
+
+	private:
+
+	vector<char> operators;		//operators and open parentheses not written yet
+	int par_depth;
+	bool expecting_operand;
+	NumberState number_state;
+	bool started;				//something has been written, so the next token needs a separator
+	bool valid;
+
+	//Writes c as a token of its own, after the separator
+	void write(char c, string &output){
+		if(started){
+			output += ' ';
+		}
+		output += c;
+		started = true;
+	}
+
+	//Writes c if it extends the number being read. The digits are written as they come, since the number is copied
+	//as it is and its value is never needed.
+	bool continue_number(char c, string &output){
+		NumberState next = next_number_state(number_state, c);
+
+		if(next == NOT_IN_NUMBER){
+			return false;
+		}
+		output += c;
+		number_state = next;
+		return true;
+	}
+
+	//A number cut off after its point or exponent mark leaves a '.' or a letter right after an operand
+	void end_number(void){
+		if(number_state == DECIMAL_POINT || number_state == EXPONENT_MARK || number_state == EXPONENT_SIGN){
+			valid = false;
+		}
+		number_state = NOT_IN_NUMBER;
+	}
+
+	//Writes the operators on the stack that bind at least as tight as priority, down to the nearest open parenthesis
+	void pop_operators(int priority, string &output){
+		while(!operators.empty() && token_type_table.priority[char_token_type(operators.back())] >= priority){
+			write(operators.back(), output);
+			operators.pop_back();
+		}
+	}
+
+	public:
+
+	StreamingInfixConverter(){
+		reset();
+	}
+
+	void reset(void){
+		operators.clear();
+		par_depth = 0;
+		expecting_operand = true;
+		valid = true;
+		number_state = NOT_IN_NUMBER;
+		started = false;
+	}
+
+	//Reads the next chunk and appends the postfix it completes to output. Returns 0, or -1 once the input can no
+	//longer be an infix expression; what was written by then is not a valid result.
+	int feed(string_view chunk, string &output){
+		for(size_t i=0; i<chunk.length() && valid; i++){
+			char c = chunk[i];
+			TokenType type = char_token_type(c);
+
+			if(number_state != NOT_IN_NUMBER){
+				if(continue_number(c, output)){
+					continue;
+				}
+				end_number();
+				if(!valid){
+					break;
+				}
+			}
+
+			if(type == SPACE || c == '\n' || c == '\r'){
+				continue;
+			}
+			if(token_type_table.is_operand[type]){
+				if(!expecting_operand){
+					valid = false;
+					break;
+				}
+				write(c, output);
+				expecting_operand = false;
+				if(type == DIGIT){
+					number_state = INTEGER_PART;
+				}
+			}
+			else if(token_type_table.is_operator[type]){
+				if(expecting_operand){
+					valid = false;
+					break;
+				}
+				pop_operators(token_type_table.priority[type], output);
+				operators.push_back(c);
+				expecting_operand = true;
+			}
+			else if(type == L_PAR){
+				if(!expecting_operand){
+					valid = false;
+					break;
+				}
+				operators.push_back(c);
+				par_depth++;
+			}
+			else if(type == R_PAR){
+				if(expecting_operand || par_depth == 0){
+					valid = false;
+					break;
+				}
+				pop_operators(1, output);
+				operators.pop_back();
+				par_depth--;
+			} else {
+				valid = false;
+			}
+		}
+
+		if(!valid){
+			return -1;
+		}
+		return 0;
+	}
+
+	//Ends the input and appends the operators still on the stack. Returns 0, or -1 if the input was not an infix
+	//expression.
+	int finish(string &output){
+		if(number_state != NOT_IN_NUMBER && valid){
+			end_number();
+		}
+		if(!valid || expecting_operand || par_depth != 0){
+			return -1;
+		}
+		pop_operators(1, output);
+		return 0;
+	}
+
+	//Operators and open parentheses waiting on the stack: all the memory the conversion holds between chunks
+	int depth(void){
+		return operators.size();
+	}
+
+};
+
+//Converts one infix expression read from input in blocks of buffer_size bytes to postfix, writing the output a block
+//at a time. The expression may be far larger than memory. ERROR_EXPR follows on a line of its own when the input
+//turns out not to be an infix expression.
+int process_infix_stream(istream &input, ostream &output, int buffer_size){
+
+	vector<char> buffer(buffer_size);
+	string postfix;
+	StreamingInfixConverter converter;
+	int status = 0;
+
+	postfix.reserve(2 * buffer_size);
+	while(input && status == 0){
+		input.read(buffer.data(), buffer_size);
+		status = converter.feed(string_view(buffer.data(), input.gcount()), postfix);
+		output.write(postfix.data(), postfix.length());
+		postfix.clear();
+	}
+	if(status == 0){
+		status = converter.finish(postfix);
+	}
+	output.write(postfix.data(), postfix.length());
+	if(status != 0){
+		output << '\n' << "ERROR_EXPR";
+	}
+	output << '\n';
+	output.flush();
+
+	return status == 0 ? 0 : 1;
+}
+
+//Finds the notation of an expression handed over in chunks of any size, for input that arrives a piece at a time.
+//Tokens go straight into a NotationRecognizer, so no part of the input is kept, not even a number split between two
+//chunks, and the verdict is ready as soon as the last chunk has been fed. Gives the same verdict as
+//Expression::classify on the whole text.
+class StreamingClassifier{
+
+	private:
+
+	NotationRecognizer recognizer;
+	NumberState number_state;
+	TokenType exponent_sign;	//the sign after an exponent mark, kept in case no digit follows it
+	bool ended;					//a '\0' ends the expression, as it does for the lexer
+
+	//Follows c into the number being read if the lexer would
+	bool continue_number(char c){
+		NumberState next = next_number_state(number_state, c);
+
+		if(next == EXPONENT_SIGN){
+			exponent_sign = char_token_type(c);
+		}
+
+		if(next == NOT_IN_NUMBER){
+			return false;
+		}
+		number_state = next;
+		return true;
+	}
+
+	//The lexer only takes a '.' or an exponent into a number when a digit follows. When none did, the number ends
+	//before them and they are tokens of their own.
+	void end_number(void){
+		recognizer.read(DIGIT);
+		if(number_state == DECIMAL_POINT){
+			recognizer.read(ERROR_TOKEN);
+		}
+		else if(number_state == EXPONENT_MARK){
+			recognizer.read(LETTER);
+		}
+		else if(number_state == EXPONENT_SIGN){
+			recognizer.read(LETTER);
+			recognizer.read(exponent_sign);
+		}
+		number_state = NOT_IN_NUMBER;
+	}
+
+	public:
+
+	StreamingClassifier(){
+		reset();
+	}
+
+	void reset(void){
+		recognizer.reset();
+		number_state = NOT_IN_NUMBER;
+		exponent_sign = ADD_OP;
+		ended = false;
+	}
+
+	//Reads the next chunk. Returns 0, or -1 once no grammar can accept the input, so the rest need not be sent.
+	int feed(string_view chunk){
+		for(size_t i=0; i<chunk.length() && !ended && !recognizer.failed(); i++){
+			char c = chunk[i];
+			if(number_state != NOT_IN_NUMBER){
+				if(continue_number(c)){
+					continue;
+				}
+				end_number();
+			}
+
+			TokenType type = char_token_type(c);
+			if(type == END){
+				ended = true;
+			}
+			else if(type == DIGIT){
+				number_state = INTEGER_PART;
+			}
+			else if(type != SPACE){
+				recognizer.read(type);
+			}
+		}
+
+		if(recognizer.failed()){
+			return -1;
+		}
+		return 0;
+	}
+
+	//The notation of everything fed since the last reset
+	ExpressionType finish(void){
+		if(number_state != NOT_IN_NUMBER){
+			end_number();
+		}
+		return recognizer.verdict();
+	}
+
+};
+
+//Writes the batch output line for one input line: the type, the other two notations and, when it
+//can be evaluated, the answer, separated by tabs. A trailing carriage return is dropped so files
+//saved on Windows give the same output.
+void process_batch_line(string_view line, string &results){
+	if(!line.empty() && line[line.length() - 1] == '\r'){
+		line.remove_suffix(1);
+	}
+	Expression expr(line);
+	expr.append_equivalents(results);
+	double answer;
+	if(expr.evaluate(answer) == 0){
+		char text[32];
+		snprintf(text, sizeof(text), "%.15g", answer);
+		results += '\t';
+		results += text;
+	}
+	else if(expr.get_type() != ERROR_EXPR){
+		results += "\tERROR";
+	}
+	results += '\n';
+}
+
+//Reads newline separated expressions from input in blocks of buffer_size bytes and writes their results in blocks of
+//about the same size, so nothing is flushed per line. A line inside one block is read where it is; only a line split
+//between two reads is copied, so memory does not grow with the input.
+int process_batch(istream &input, ostream &output, int buffer_size){
+
+	vector<char> buffer(buffer_size);
+	string line, results;
+	results.reserve(buffer_size);
+
+	while(input){
+		input.read(buffer.data(), buffer_size);
+		const char* position = buffer.data();
+		const char* end = position + input.gcount();
+		while(position < end){
+			const char* newline = (const char*) memchr(position, '\n', end - position);
+			if(newline == NULL){
+				line.append(position, end);
+				break;
+			}
+			if(line.empty()){
+				process_batch_line(string_view(position, newline - position), results);
+			} else {
+				line.append(position, newline);
+				process_batch_line(line, results);
+				line.clear();
+			}
+			position = newline + 1;
+			if((int) results.length() >= buffer_size){
+				output.write(results.data(), results.length());
+				results.clear();
+			}
+		}
+	}
+	if(!line.empty()){
+		process_batch_line(line, results);
+	}
+	output.write(results.data(), results.length());
+	output.flush();
+
+	return 0;
+}
+
+//Runs process_batch_line on every line of a chunk. A last line without a newline is processed too.
+void process_batch_chunk(string_view input, string &results){
+	size_t start = 0;
+	while(start < input.length()){
+		size_t end = input.find('\n', start);
+		if(end == string_view::npos){
+			end = input.length();
+		}
+		process_batch_line(input.substr(start, end - start), results);
+		start = end + 1;
+	}
+}
+
+//A whole file mapped read only into memory, so it can be read in place instead of copied into buffers. Only where
+//mmap exists; elsewhere open() fails and batch mode reads the file instead.
+class MappedFile{
+
+	private:
+
+	const char* bytes;
+	size_t length;
+
+	void unmap(void){
+#ifdef MAPPED_INPUT
+		if(bytes != NULL){
+			munmap((void*) bytes, length);
+		}
+#endif
+		bytes = NULL;
+		length = 0;
+	}
+
+	public:
+
+	MappedFile(){
+		bytes = NULL;
+		length = 0;
+	}
+
+	//Only one MappedFile may own a mapping, or it would be unmapped twice. A move hands it over.
+	MappedFile(const MappedFile &other) = delete;
+	MappedFile& operator=(const MappedFile &other) = delete;
+
+	MappedFile(MappedFile &&other){
+		bytes = other.bytes;
+		length = other.length;
+		other.bytes = NULL;
+		other.length = 0;
+	}
+
+	MappedFile& operator=(MappedFile &&other){
+		if(this != &other){
+			unmap();
+			bytes = other.bytes;
+			length = other.length;
+			other.bytes = NULL;
+			other.length = 0;
+		}
+		return *this;
+	}
+
+	~MappedFile(){
+		unmap();
+	}
+
+	int open(const char* path){
+#ifdef MAPPED_INPUT
+		unmap();
+		int descriptor = ::open(path, O_RDONLY);
+		if(descriptor == -1){
+			return -1;
+		}
+		struct stat file_status;
+		if(fstat(descriptor, &file_status) != 0){
+			close(descriptor);
+			return -1;
+		}
+		length = file_status.st_size;
+		if(length > 0){
+			void* mapping = mmap(NULL, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+			if(mapping == MAP_FAILED){
+				close(descriptor);
+				length = 0;
+				return -1;
+			}
+			bytes = (const char*) mapping;
+			madvise(mapping, length, MADV_SEQUENTIAL);
+		}
+		close(descriptor);
+		return 0;
+#else
+		return -1;
+#endif
+	}
+
+	string_view text(void){
+		return string_view(bytes, length);
+	}
+
+	//Lets the kernel drop the pages before end, which have been read already, so the resident size stays small
+	void release(size_t end){
+#ifdef MAPPED_INPUT
+		size_t page_size = sysconf(_SC_PAGESIZE);
+		end -= end % page_size;
+		if(end > 0){
+			madvise((void*) bytes, end, MADV_DONTNEED);
+		}
+#endif
+	}
+
+};
+
+//A block of whole input lines and, once a worker is done with it, their output lines
+struct BatchChunk{
+
+	string input;
+	string_view text;		//the lines to convert: input, or a slice of a mapped file
+	string output;
+	bool processed;
+
+};
+
+//Batch mode on several threads: the calling thread reads the input into chunks of whole lines, the workers convert
+//them, and a writer thread writes the results in input order. Every worker has its own queue of chunks and takes
+//from the back of another worker's queue when its own runs dry, so a worker stuck on slow lines does not hold up the
+//rest. At most four chunks per worker are in memory at any time.
+class BatchPipeline{
+
+	private:
+
+	int thread_count;
+	int chunk_size;
+	int max_in_flight;
+
+	vector<BatchChunk> slots;				//chunk number % max_in_flight
+	vector< deque<long long> > queues;		//chunk numbers waiting for a worker
+	vector<mutex> queue_locks;
+
+	mutex state_lock;
+	condition_variable space_available;		//reader waits for the writer to free a slot
+	condition_variable work_available;		//workers wait for the reader
+	condition_variable chunk_processed;		//writer waits for the workers
+	long long chunks_read;
+	long long chunks_written;
+	int chunks_queued;						//chunks in the queues, not yet taken by a worker
+	bool reading_done;
+
+	vector<thread> workers;
+	thread writer;
+
+	MappedFile* mapped_file;		//the mapping the chunks are slices of, or NULL when they are copies
+	size_t released;				//bytes of mapped_file already given back to the kernel
+
+	//Takes the oldest chunk of the worker's own queue, or else steals the newest chunk of another worker
+	bool take_chunk(int worker, long long &chunk){
+		chunk = -1;
+		for(int k=0; k<thread_count; k++){
+			int victim = (worker + k) % thread_count;
+			lock_guard<mutex> queue_lock(queue_locks[victim]);
+			if(queues[victim].empty()){
+				continue;
+			}
+			if(k == 0){
+				chunk = queues[victim].front();
+				queues[victim].pop_front();
+			} else {
+				chunk = queues[victim].back();
+				queues[victim].pop_back();
+			}
+			break;
+		}
+		if(chunk == -1){
+			return false;
+		}
+		lock_guard<mutex> lock(state_lock);
+		chunks_queued--;
+		return true;
+	}
+
+	void work(int worker){
+		long long chunk;
+		while(true){
+			if(take_chunk(worker, chunk)){
+				BatchChunk &slot = slots[chunk % max_in_flight];
+				process_batch_chunk(slot.text, slot.output);
+				lock_guard<mutex> lock(state_lock);
+				slot.processed = true;
+				chunk_processed.notify_one();
+				continue;
+			}
+
+			unique_lock<mutex> lock(state_lock);
+			while(chunks_queued <= 0 && !reading_done){
+				work_available.wait(lock);
+			}
+			if(chunks_queued <= 0){
+				return;
+			}
+		}
+	}
+
+	void write(ostream &output){
+		for(long long chunk=0; ; chunk++){
+			BatchChunk &slot = slots[chunk % max_in_flight];
+			{
+				unique_lock<mutex> lock(state_lock);
+				while(!(chunk < chunks_read && slot.processed) && !(reading_done && chunk == chunks_read)){
+					chunk_processed.wait(lock);
+				}
+				if(chunk == chunks_read){
+					break;
+				}
+			}
+
+			output.write(slot.output.data(), slot.output.length());
+			slot.output.clear();
+
+			//Chunks are written in input order, so every byte of the mapping before this one's end has been read
+			if(mapped_file != NULL){
+				size_t consumed = slot.text.data() + slot.text.length() - mapped_file->text().data();
+				if(consumed - released >= (16 << 20)){
+					mapped_file->release(consumed);
+					released = consumed;
+				}
+			}
+
+			lock_guard<mutex> lock(state_lock);
+			slot.processed = false;
+			chunks_written = chunk + 1;
+			space_available.notify_one();
+		}
+		output.flush();
+	}
+
+	//Waits until the writer has freed a slot and returns the number of the next chunk
+	long long next_chunk(void){
+		unique_lock<mutex> lock(state_lock);
+		while(chunks_read - chunks_written >= max_in_flight){
+			space_available.wait(lock);
+		}
+		return chunks_read;
+	}
+
+	void queue_chunk(long long chunk){
+		{
+			lock_guard<mutex> queue_lock(queue_locks[chunk % thread_count]);
+			queues[chunk % thread_count].push_back(chunk);
+		}
+
+		lock_guard<mutex> lock(state_lock);
+		chunks_read++;
+		chunks_queued++;
+		work_available.notify_all();
+	}
+
+	void publish(string &text){
+		long long chunk = next_chunk();
+		BatchChunk &slot = slots[chunk % max_in_flight];
+		slot.input.swap(text);
+		slot.text = slot.input;
+		queue_chunk(chunk);
+	}
+
+	void publish(string_view text){
+		long long chunk = next_chunk();
+		slots[chunk % max_in_flight].text = text;
+		queue_chunk(chunk);
+	}
+
+	void start(ostream &output){
+		for(int i=0; i<thread_count; i++){
+			workers.push_back(thread(&BatchPipeline::work, this, i));
+		}
+		writer = thread(&BatchPipeline::write, this, ref(output));
+	}
+
+	void finish(void){
+		{
+			lock_guard<mutex> lock(state_lock);
+			reading_done = true;
+			work_available.notify_all();
+			chunk_processed.notify_one();
+		}
+		for(int i=0; i<thread_count; i++){
+			workers[i].join();
+		}
+		writer.join();
+	}
+
+	public:
+
+	BatchPipeline(int init_thread_count, int init_chunk_size) : queues(init_thread_count), queue_locks(init_thread_count){
+		thread_count = init_thread_count;
+		chunk_size = init_chunk_size;
+		max_in_flight = 4 * thread_count;
+		slots.resize(max_in_flight);
+		for(int i=0; i<max_in_flight; i++){
+			slots[i].processed = false;
+		}
+		chunks_read = 0;
+		chunks_written = 0;
+		chunks_queued = 0;
+		reading_done = false;
+		mapped_file = NULL;
+		released = 0;
+	}
+
+	int run(istream &input, ostream &output){
+
+		start(output);
+
+		//A chunk ends at the last newline read so far. The rest waits for the next read.
+		vector<char> buffer(chunk_size);
+		string pending, text;
+		while(input){
+			input.read(buffer.data(), chunk_size);
+			pending.append(buffer.data(), input.gcount());
+			size_t last_newline = pending.rfind('\n');
+			if(last_newline == string::npos){
+				continue;
+			}
+			text.assign(pending, 0, last_newline + 1);
+			pending.erase(0, last_newline + 1);
+			publish(text);
+		}
+		if(!pending.empty()){
+			publish(pending);
+		}
+
+		finish();
+		return 0;
+	}
+
+	//Same as above over text that is already in memory, such as a mapped file. The chunks are slices of it.
+	int run(string_view input, ostream &output){
+
+		start(output);
+
+		size_t position = 0;
+		while(position < input.length()){
+			size_t end = input.find('\n', min(position + chunk_size, input.length()) - 1);
+			if(end == string_view::npos){
+				end = input.length() - 1;
+			}
+			publish(input.substr(position, end + 1 - position));
+			position = end + 1;
+		}
+
+		finish();
+		return 0;
+	}
+
+	//Same as above over a mapped file, giving its pages back to the kernel once their chunks are written so the
+	//resident size stays bounded by the chunks in flight instead of growing with the file
+	int run(MappedFile &file, ostream &output){
+		mapped_file = &file;
+		return run(file.text(), output);
+	}
+
+};
+
+//Same output as process_batch above, with the lines converted by thread_count threads
+int process_batch(istream &input, ostream &output, int buffer_size, int thread_count){
+	if(thread_count <= 1){
+		return process_batch(input, output, buffer_size);
+	}
+	BatchPipeline pipeline(thread_count, buffer_size);
+	return pipeline.run(input, output);
+}
+
+//Batch mode over a mapped file. Every line handed to the tokenizer is a slice of the mapping, nothing is copied.
+int process_mapped_batch(const char* path, ostream &output, int buffer_size, int thread_count){
+
+	MappedFile file;
+	if(file.open(path) != 0){
+		return -1;
+	}
+	if(thread_count > 1){
+		BatchPipeline pipeline(thread_count, buffer_size);
+		return pipeline.run(file, output);
+	}
+
+	string_view input = file.text();
+
+	string results;
+	results.reserve(buffer_size);
+
+	size_t position = 0, released = 0;
+	while(position < input.length()){
+		size_t end = input.find('\n', position);
+		if(end == string_view::npos){
+			end = input.length();
+		}
+		process_batch_line(input.substr(position, end - position), results);
+		position = end + 1;
+
+		if((int) results.length() >= buffer_size){
+			output.write(results.data(), results.length());
+			results.clear();
+		}
+		if(position - released >= (16 << 20)){
+			file.release(position);
+			released = position;
+		}
+	}
+	output.write(results.data(), results.length());
+	output.flush();
+
+	return 0;
+}
+
+//A tree node allocated on its own, only used to compare against ExpressionArena in ExpressionsTester
+struct PointerNode{
+
+	char symbol;
+	PointerNode* left;
+	PointerNode* right;
+
+};
+
+class ExpressionsTester{
+
+
+	private:
+
+	vector<string> infix_expressions;
+	vector<string> prefix_expressions;
+	vector<string> postfix_expressions;
+
+	//The old way of finding the notation: every parser copies and lexes the input again until one accepts it.
+	ExpressionType evaluate_type_with_parsers(string_view expression){
+		InfixExpressionParser infix_parser(expression);
+		if(infix_parser.parse() == 0){
+			return INFIX;
+		}
+		PrefixExpressionParser prefix_parser(expression);
+		if(prefix_parser.parse() == 0){
+			return PREFIX;
+		}
+		PostfixExpressionParser postfix_parser(expression);
+		if(postfix_parser.parse() == 0){
+			return POSTFIX;
+		}
+		return ERROR_EXPR;
+	}
+
+	//Expression::classify without the screen in front: every input is lexed and run through the grammars
+	ExpressionType classify_unscreened(string_view input){
+		static vector<Token> scratch;
+		ExpressionLexer lexer(input);
+		lexer.tokenize(scratch);
+		ExpressionClassifier classifier(scratch);
+		return classifier.classify();
+	}
+
+	double nanoseconds_per_classification(vector<string> &corpus, int rounds, bool screened){
+		int checksum = 0;
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for(int round=0; round<rounds; round++){
+			for(int i=0; i<(int) corpus.size(); i++){
+				if(screened){
+					checksum += Expression::classify(corpus.at(i));
+				} else {
+					checksum += classify_unscreened(corpus.at(i));
+				}
+			}
+		}
+		chrono::steady_clock::time_point stop = chrono::steady_clock::now();
+		if(checksum < 0){
+			cout << checksum << endl;
+		}
+		return chrono::duration<double, nano>(stop - start).count() / ((double) rounds * corpus.size());
+	}
+
+	enum TypeCheck{
+
+		THREE_PARSERS,
+		SHARED_TOKENS,
+		LEX_AND_CLASSIFY,
+		FULL_EXPRESSION
+
+	};
+
+	//THREE_PARSERS is the chain the classifier replaced. SHARED_TOKENS times ExpressionClassifier alone on tokens lexed
+	//beforehand, which is what detection costs once the lexer's tokens are shared with the converters.
+	//LEX_AND_CLASSIFY is Expression::classify, and FULL_EXPRESSION also builds the tree.
+	double nanoseconds_per_type_check(vector<string> &corpus, int rounds, TypeCheck check){
+		int checksum = 0;
+		vector<vector<Token>> token_buffers(corpus.size());
+		for(int i=0; i<(int) corpus.size(); i++){
+			ExpressionLexer lexer(corpus.at(i));
+			lexer.tokenize(token_buffers.at(i));
+		}
+
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for(int round=0; round<rounds; round++){
+			for(int i=0; i<(int) corpus.size(); i++){
+				if(check == THREE_PARSERS){
+					checksum += evaluate_type_with_parsers(corpus.at(i));
+				}
+				else if(check == SHARED_TOKENS){
+					ExpressionClassifier classifier(token_buffers.at(i));
+					checksum += classifier.classify();
+				}
+				else if(check == LEX_AND_CLASSIFY){
+					checksum += Expression::classify(corpus.at(i));
+				} else {
+					Expression expr(corpus.at(i));
+					checksum += expr.get_type();
+				}
+			}
+		}
+		chrono::steady_clock::time_point stop = chrono::steady_clock::now();
+		if(checksum < 0){
+			cout << checksum << endl;
+		}
+		return chrono::duration<double, nano>(stop - start).count() / ((double) rounds * corpus.size());
+	}
+
+	//The postfix path parse_postfix replaced: ExpressionClassifier checks the arity with a counter, then build_tree read
+	//the tokens again with a stack to build the tree. Returns the root, or -1 when input is not a postfix expression.
+	int build_postfix_in_two_passes(string_view input, vector<Token> &tokens, ExpressionArena &arena){
+		ExpressionScreen screen(input);
+		if(screen.rejects()){
+			return -1;
+		}
+		ExpressionLexer lexer(input);
+		lexer.tokenize(tokens);
+		ExpressionClassifier classifier(tokens);
+		if(classifier.classify() != POSTFIX){
+			return -1;
+		}
+
+		stack<int> operands;
+		arena.reset(tokens.size());
+		for(int i=0; tokens[i].type != END; i++){
+			int left = -1, right = -1;
+			if(token_type_table.is_operator[tokens[i].type]){
+				right = operands.top();
+				operands.pop();
+				left = operands.top();
+				operands.pop();
+			}
+			operands.push(arena.allocate(tokens[i], left, right, token_type_table.priority[tokens[i].type]));
+		}
+		return operands.top();
+	}
+
+	//Resident set size of this process in KB, read from /proc/self/statm. 0 where that file does not exist.
+	long long resident_kilobytes(void){
+		ifstream statm("/proc/self/statm");
+		long long pages = 0, resident = 0;
+		statm >> pages >> resident;
+#ifdef MAPPED_INPUT
+		return resident * (sysconf(_SC_PAGESIZE) / 1024);
+#else
+		return resident * 4;
+#endif
+	}
+
+	//The if/else chain the lexers used before the character table, kept to compare against in lexer_benchmark
+	TokenType char_type_with_branches(char c){
+		if(c == '+'){
+			return ADD_OP;
+		}
+		else if(c == '-'){
+			return SUB_OP;
+		}
+		else if(c == '*'){
+			return MULT_OP;
+		}
+		else if(c == '/'){
+			return DIV_OP;
+		}
+		else if(c == '^'){
+			return EXP_OP;
+		}
+		else if(c == '('){
+			return L_PAR;
+		}
+		else if(c == ')'){
+			return R_PAR;
+		}
+		else if(c >= '0' && c <= '9'){
+			return DIGIT;
+		}
+		else if(c == '_'){
+			return UNDERSCORE;
+		}
+		else if((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')){
+			return LETTER;
+		}
+		else if(c == '\0'){
+			return END;
+		}
+		else if(c == ' '){
+			return SPACE;
+		}
+		return ERROR_TOKEN;
+	}
+
+	//A random prefix expression with the given number of operators, for the benchmarks
+	string generate_prefix(int operator_count){
+		string prefix = "";
+		string operators = "+-*/^";
+		int operators_left = operator_count;
+		int operands_left = operator_count + 1;
+		int operands_needed = 1;
+		unsigned int seed = 124;
+
+		prefix.reserve(2 * operator_count + 1);
+		while(operands_left > 0){
+			seed = seed * 1103515245 + 12345;
+			bool pick_operator = false;
+			if(operators_left > 0 && operands_needed == 1){
+				pick_operator = true;
+			}
+			else if(operators_left > 0 && (seed >> 16) % (operators_left + operands_left) < (unsigned int) operators_left){
+				pick_operator = true;
+			}
+
+			if(pick_operator){
+				prefix += operators[(seed >> 8) % operators.length()];
+				operators_left--;
+				operands_needed++;
+			} else {
+				prefix += (char) ('a' + (seed >> 8) % 26);
+				operands_left--;
+				operands_needed--;
+			}
+		}
+
+		return prefix;
+	}
+
+	//What prefix_to_postfix used to do: every operator copies both operand strings into a new one
+	string prefix_to_postfix_with_strings(string prefix){
+		stack<string> op_stack;
+		for(int i=prefix.length()-1; i>=0; i--){
+			if(prefix[i] >= 'a' && prefix[i] <= 'z'){
+				op_stack.push(string(1, prefix[i]));
+			} else {
+				string postfix = op_stack.top();
+				op_stack.pop();
+				postfix += op_stack.top();
+				op_stack.pop();
+				postfix += prefix[i];
+				op_stack.push(postfix);
+			}
+		}
+		return op_stack.top();
+	}
+
+	string postfix_to_prefix_with_strings(string postfix){
+		stack<string> op_stack;
+		for(int i=0; i<(int) postfix.length(); i++){
+			if(postfix[i] >= 'a' && postfix[i] <= 'z'){
+				op_stack.push(string(1, postfix[i]));
+			} else {
+				string operand_two = op_stack.top();
+				op_stack.pop();
+				string operand_one = op_stack.top();
+				op_stack.pop();
+				op_stack.push(postfix[i] + operand_one + operand_two);
+			}
+		}
+		return op_stack.top();
+	}
+
+	//The old prefix to infix conversion: each operand is a string that is rescanned for its loosest operator and has
+	//its parentheses stripped by shifting it, so a chain of n operators costs O(n^2). Only used for comparison.
+	string prefix_to_infix_with_strings(string prefix){
+		stack<string> op_stack;
+		for(int i=prefix.length()-1; i>=0; i--){
+			if(prefix[i] >= 'a' && prefix[i] <= 'z'){
+				op_stack.push(string(1, prefix[i]));
+				continue;
+			}
+			string operands[2];
+			int priority = token_type_table.priority[char_token_type(prefix[i])];
+			for(int k=0; k<2; k++){
+				operands[k] = op_stack.top();
+				op_stack.pop();
+				int least_priority = 100, depth = 0;
+				for(int c=0; c<(int) operands[k].length() && operands[k].length() > 1; c++){
+					TokenType type = char_token_type(operands[k][c]);
+					if(token_type_table.is_operator[type] && depth < 2 && token_type_table.priority[type] < least_priority){
+						least_priority = token_type_table.priority[type];
+					}
+					depth += (type == L_PAR) - (type == R_PAR);
+				}
+				if(operands[k].length() > 1 && least_priority >= priority){
+					operands[k].erase(0, 1);
+					operands[k].pop_back();
+				}
+			}
+			op_stack.push("(" + operands[0] + prefix[i] + operands[1] + ")");
+		}
+		return op_stack.top();
+	}
+
+	string prefix_to_postfix_with_pointers(string prefix){
+		stack<PointerNode*> operands;
+		for(int i=prefix.length()-1; i>=0; i--){
+			PointerNode* node = new PointerNode;
+			node->symbol = prefix[i];
+			node->left = NULL;
+			node->right = NULL;
+			if(!(prefix[i] >= 'a' && prefix[i] <= 'z')){
+				node->left = operands.top();
+				operands.pop();
+				node->right = operands.top();
+				operands.pop();
+			}
+			operands.push(node);
+		}
+
+		string postfix = "";
+		stack<PointerNode*> pending;
+		pending.push(operands.top());
+		while(!pending.empty()){
+			PointerNode* current = pending.top();
+			pending.pop();
+			postfix += current->symbol;
+			if(current->left != NULL){
+				pending.push(current->left);
+				pending.push(current->right);
+			}
+			delete current;
+		}
+		reverse(postfix.begin(), postfix.end());
+
+		return postfix;
+	}
+
+	string prefix_to_postfix_with_arena(string prefix){
+		ExpressionArena arena;
+		stack<int> operands;
+		Token token;
+
+		arena.reset(prefix.length());
+		for(int i=prefix.length()-1; i>=0; i--){
+			int left = -1, right = -1;
+			token.offset = i;
+			token.length = 1;
+			token.type = LETTER;
+			if(!(prefix[i] >= 'a' && prefix[i] <= 'z')){
+				token.type = ADD_OP;
+				left = operands.top();
+				operands.pop();
+				right = operands.top();
+				operands.pop();
+			}
+			operands.push(arena.allocate(token, left, right, 0));
+		}
+
+		string postfix = "";
+		stack<int> pending;
+		pending.push(operands.top());
+		while(!pending.empty()){
+			int current = pending.top();
+			pending.pop();
+			postfix += prefix[arena[current].token.offset];
+			if(arena[current].left != -1){
+				pending.push(arena[current].left);
+				pending.push(arena[current].right);
+			}
+		}
+		reverse(postfix.begin(), postfix.end());
+
+		return postfix;
+	}
+
+
+	public:
+
+	ExpressionsTester(){
+
+		infix_expressions.push_back("A+B*C+D");
+		infix_expressions.push_back("(A+B)*(C+D)");
+		infix_expressions.push_back("A*B+C*D");
+		infix_expressions.push_back("A+B+C+D");
+		infix_expressions.push_back("(A+B)*C");
+		infix_expressions.push_back("A*B+C/D");
+		infix_expressions.push_back("A*(B+C)/D");
+		infix_expressions.push_back("a*(b+c/d)");
+		infix_expressions.push_back("a*(b+c)");
+		infix_expressions.push_back("a/b+c/d");
+		infix_expressions.push_back("((a+b)*c)-d");
+		infix_expressions.push_back("(a+(((b*c)-((d/(e^f))*g))*h))");
+
+		prefix_expressions.push_back("++A*BCD");
+		prefix_expressions.push_back("*+AB+CD");
+		prefix_expressions.push_back("+*AB*CD");
+		prefix_expressions.push_back("+++ABCD");
+		prefix_expressions.push_back("*+ABC");
+		prefix_expressions.push_back("+*AB/CD");
+		prefix_expressions.push_back("/*A+BCD");
+		prefix_expressions.push_back("*a+b/cd");
+		prefix_expressions.push_back("*a+bc");
+		prefix_expressions.push_back("+/ab/cd");
+		prefix_expressions.push_back("-*+abcd");
+		prefix_expressions.push_back("+a*-*bc*/d^efgh");
+
+		postfix_expressions.push_back("ABC*+D+");
+		postfix_expressions.push_back("AB+CD+*");
+		postfix_expressions.push_back("AB*CD*+");
+		postfix_expressions.push_back("AB+C+D+");
+		postfix_expressions.push_back("AB+C*");
+		postfix_expressions.push_back("AB*CD/+");
+		postfix_expressions.push_back("ABC+*D/");
+		postfix_expressions.push_back("abcd/+*");
+		postfix_expressions.push_back("abc+*");
+		postfix_expressions.push_back("ab/cd/+");
+		postfix_expressions.push_back("ab+c*d-");
+		postfix_expressions.push_back("abc*def^/g*-h*+");
+
+	}
+
+	int InfixExpressionTester(){
+		
+		cout << "Testing Infix Expression Parser" << endl;
+
+		bool show_details = false;
+		int expected, result;
+
+		expected = 0;
+		for(int i=0; i<infix_expressions.size(); i++){
+			InfixExpressionParser infix_tester(infix_expressions.at(i));
+			result = infix_tester.parse();
+			if(show_details){
+				cout << "\n--- POSITIVE TEST NO " << i << "---" << endl;
+				cout << "Expression:\t" << infix_expressions.at(i) << endl;
+				cout << "Expected:\t" ;
+				if(expected == 0){
+					cout << "VALID" << endl;
+				} else{
+					cout << "INVALID" << endl;
+				}
+
+				cout << "Actual:\t";
+				if(result == 0){
+					cout << "VALID" << endl;
+				} else{
+					cout << "INVALID" << endl;
+				}
+			}
+			cout << "Result:\t";
+
+			if(expected == result){
+				cout << "PASSED" << endl;
+			} else{
+				cout << "FAILED" << endl;
+			}
+
+		}
+
+		expected = 1;
+		for(int i=0; i<prefix_expressions.size(); i++){
+
+			InfixExpressionParser infix_tester(prefix_expressions.at(i));
+			result = infix_tester.parse();
+			if(show_details){
+				cout << "\n--- FIRST NEGATIVE TEST NO " << i << " ---" << endl;
+				cout << "Expression:\t" << prefix_expressions.at(i) << endl;
+				cout << "Expected:\t" ;
+				if(expected == 0){
+					cout << "VALID" << endl;
+				} else{
+					cout << "INVALID" << endl;
+				}
+				cout << "Actual:\t";
+				if(result == 0){
+					cout << "VALID" << endl;
+				} else{
+					cout << "INVALID" << endl;
+				}
+			}
+			cout << "Result:\t";
+
+			if(expected == result){
+				cout << "PASSED" << endl;
+			} else{
+				cout << "FAILED" << endl;
+			}
+
+		}
+		
+		expected = 1;
+		for(int i=0; i<postfix_expressions.size(); i++){
+
+			InfixExpressionParser infix_tester(postfix_expressions.at(i));
+			result = infix_tester.parse();
+			if(show_details){
+				cout << "\n--- SECOND NEGATIVE TEST NO " << i << " ---" << endl;
+				cout << "Expression:\t" << postfix_expressions.at(i) << endl;
+				cout << "Expected:\t" << "VALID" << endl;
+				cout << "Actual:\t";
+				if(result == 0){
+					cout << "VALID" << endl;
+				} else{
+					cout << "INVALID" << endl;
+				}
+			}
+			cout << "Result:\t";
+
+			if(expected == result){
+				cout << "PASSED" << endl;
+			} else{
+				cout << "FAILED" << endl;
+			}
+
+		}
+
+
+	return 0;
+	}
+
+	int PrefixExpressionTester(){
+		
+		cout << "Testing Prefix Expression Parser" << endl;
+
+		bool show_details = false;
+		int expected, result;
+
+		expected = 1;
+		for(int i=0; i<infix_expressions.size(); i++){
+			PrefixExpressionParser prefix_tester(infix_expressions.at(i));
+			result = prefix_tester.parse();
+			if(show_details){
+				cout << "\n--- FIRST NEGATIVE TEST NO " << i << "---" << endl;
+				cout << "Expression:\t" << infix_expressions.at(i) << endl;
+				cout << "Expected:\t" ;
+				if(expected == 0){
+					cout << "VALID" << endl;
+				} else{
+					cout << "INVALID" << endl;
+				}
+
+				cout << "Actual:\t";
+				if(result == 0){
+					cout << "VALID" << endl;
+				} else{
+					cout << "INVALID" << endl;
+				}
+			}
+			cout << "Result:\t";
+
+			if(expected == result){
+				cout << "PASSED" << endl;
+			} else{
+				cout << "FAILED" << endl;
+			}
+
+		}
+
+		expected = 0;
+		for(int i=0; i<prefix_expressions.size(); i++){
+
+			PrefixExpressionParser prefix_tester(prefix_expressions.at(i));
+			result = prefix_tester.parse();
+			if(show_details){
+				cout << "\n--- POSTIIVE TEST NO " << i << " ---" << endl;
+				cout << "Expression:\t" << prefix_expressions.at(i) << endl;
+				cout << "Expected:\t" ;
+				if(expected == 0){
+					cout << "VALID" << endl;
+				} else{
+					cout << "INVALID" << endl;
+				}
+				cout << "Actual:\t";
+				if(result == 0){
+					cout << "VALID" << endl;
+				} else{
+					cout << "INVALID" << endl;
+				}
+			}
+			cout << "Result:\t";
+
+			if(expected == result){
+				cout << "PASSED" << endl;
+			} else{
+				cout << "FAILED" << endl;
+			}
+
+		}
+		
+		expected = 1;
+		for(int i=0; i<postfix_expressions.size(); i++){
+
+			PrefixExpressionParser prefix_tester(postfix_expressions.at(i));
+			result = prefix_tester.parse();
+			if(show_details){
+				cout << "\n--- SECOND NEGATIVE TEST NO " << i << " ---" << endl;
+				cout << "Expression:\t" << postfix_expressions.at(i) << endl;
+				cout << "Expected:\t" << "VALID" << endl;
+				cout << "Actual:\t";
+				if(result == 0){
+					cout << "VALID" << endl;
+				} else{
+					cout << "INVALID" << endl;
+				}
+			}
+			cout << "Result:\t";
+
+			if(expected == result){
+				cout << "PASSED" << endl;
+			} else{
+				cout << "FAILED" << endl;
+			}
+
+		}
+
+
+	return 0;
+	}
+
+	int PostfixExpressionTester(){
+		
+		cout << "Testing Postfix Expression Parser" << endl;
+
+		bool show_details = false;
+		int expected, result;
+
+		expected = 1;
+		for(int i=0; i<infix_expressions.size(); i++){
+			PostfixExpressionParser postfix_tester(infix_expressions.at(i));
+			result = postfix_tester.parse();
+			if(show_details){
+				cout << "\n--- FIRST NEGATIVE TEST NO " << i << "---" << endl;
+				cout << "Expression:\t" << infix_expressions.at(i) << endl;
+				cout << "Expected:\t" ;
+				if(expected == 0){
+					cout << "VALID" << endl;
+				} else{
+					cout << "INVALID" << endl;
+				}
+
+				cout << "Actual:\t";
+				if(result == 0){
+					cout << "VALID" << endl;
+				} else{
+					cout << "INVALID" << endl;
+				}
+			}
+			cout << "Result:\t";
+
+			if(expected == result){
+				cout << "PASSED" << endl;
+			} else{
+				cout << "FAILED" << endl;
+			}
+
+		}
+
+		expected = 1;
+		for(int i=0; i<prefix_expressions.size(); i++){
+
+			PostfixExpressionParser postfix_tester(prefix_expressions.at(i));
+			result = postfix_tester.parse();
+			if(show_details){
+				cout << "\n--- SECOND NEGATIVE TEST NO " << i << " ---" << endl;
+				cout << "Expression:\t" << prefix_expressions.at(i) << endl;
+				cout << "Expected:\t" ;
+				if(expected == 0){
+					cout << "VALID" << endl;
+				} else{
+					cout << "INVALID" << endl;
+				}
+				cout << "Actual:\t";
+				if(result == 0){
+					cout << "VALID" << endl;
+				} else{
+					cout << "INVALID" << endl;
+				}
+			}
+			cout << "Result:\t";
+
+			if(expected == result){
+				cout << "PASSED" << endl;
+			} else{
+				cout << "FAILED" << endl;
+			}
+
+		}
+		
+		expected = 0;
+		for(int i=0; i<postfix_expressions.size(); i++){
+
+			PostfixExpressionParser postfix_tester(postfix_expressions.at(i));
+			result = postfix_tester.parse();
+			if(show_details){
+				cout << "\n--- POSITIVE TEST NO " << i << " ---" << endl;
+				cout << "Expression:\t" << postfix_expressions.at(i) << endl;
+				cout << "Expected:\t" << "VALID" << endl;
+				cout << "Actual:\t";
+				if(result == 0){
+					cout << "VALID" << endl;
+				} else{
+					cout << "INVALID" << endl;
+				}
+			}
+			cout << "Result:\t";
+
+			if(expected == result){
+				cout << "PASSED" << endl;
+			} else{
+				cout << "FAILED" << endl;
+			}
+
+		}
+
+
+	return 0;
+	}
+
+	int infixToPrefixTester(){
+
+		cout << "Testing Infix to Prefix Conversions" << endl;
+		bool show_details = false;
+		string result = "", expected = "";
+
+
+		for(int i=0; i<infix_expressions.size(); i++){
+			
+			Expression test_expr(infix_expressions.at(i));
+			result = test_expr.infix_to_prefix();
+			expected = prefix_expressions.at(i);
+			if(show_details){
+				cout << "\n--- TEST NO " << i << "---" << endl;
+				cout << "Expression:\t" << infix_expressions.at(i) << endl;
+				cout << "Expected:\t" << expected << endl;
+				cout << "Actual:\t\t" << result << endl;
+			}
+
+			cout << "Result:\t";
+
+			if(expected == result){
+					cout << "PASSED" << endl;
+			} else {
+				cout << "FAILED" << endl;
+			}
+
+		}
+		
+		return 0;
+	}
+
+	int infixToPostfixTester(){
+
+		cout << "Testing Infix to Postfix Conversions" << endl;
+		bool show_details = false;
+		string result = "", expected = "";
+
+
+		for(int i=0; i<infix_expressions.size(); i++){
+			
+			Expression test_expr(infix_expressions.at(i));
+			result = test_expr.infix_to_postfix();
+			expected = postfix_expressions.at(i);
+			if(show_details){
+				cout << "\n--- TEST NO " << i << "---" << endl;
+				cout << "Expression:\t" << infix_expressions.at(i) << endl;
+				cout << "Expected:\t" << expected << endl;
+				cout << "Actual:\t\t" << result << endl;
+			}
+
+			cout << "Result:\t";
+
+			if(expected == result){
+					cout << "PASSED" << endl;
+			} else {
+				cout << "FAILED" << endl;
+			}
+
+		}
+		
+		return 0;
+	}
+
+	int prefixToInfixTester(){
+
+		//IMPORTANT NOTE
+		//Test no 10 and 11 are supposed to passed since they are the most simplified version of the given expressions
+
+		cout << "Testing Prefix to Infix Conversions" << endl;
+		cout << "\nNote: Test no 10 and 11 are supposed to passed since they are the most simplified version of the given expressions." << endl;
+		bool show_details = false;
+		string result = "", expected = "";
+
+
+		for(int i=0; i<prefix_expressions.size(); i++){
+			
+			Expression test_expr(prefix_expressions.at(i));
+			result = test_expr.prefix_to_infix();
+			expected = infix_expressions.at(i);
+			if(show_details){
+				cout << "\n--- TEST NO " << i << "---" << endl;
+				cout << "Expression:\t" << prefix_expressions.at(i) << endl;
+				cout << "Expected:\t" << expected << endl;
+				cout << "Actual:\t\t" << result << endl;
+			}
+
+			cout << "Result:\t";
+
+			if(expected == result){
+					cout << "PASSED" << endl;
+			} else {
+				cout << "FAILED" << endl;
+			}
+
+		}
+		
+		return 0;
+	}
+
+	int prefixToPostfixTester(){
+
+
+		cout << "Testing Prefix to Postfix Conversions" << endl;
+
+		bool show_details = false;
+		string result = "", expected = "";
+
+
+		for(int i=0; i<prefix_expressions.size(); i++){
+			
+			Expression test_expr(prefix_expressions.at(i));
+			result = test_expr.prefix_to_postfix();
+			expected = postfix_expressions.at(i);
+			if(show_details){
+				cout << "\n--- TEST NO " << i << "---" << endl;
+				cout << "Expression:\t" << prefix_expressions.at(i) << endl;
+				cout << "Expected:\t" << expected << endl;
+				cout << "Actual:\t\t" << result << endl;
+			}
+
+			cout << "Result:\t";
+
+			if(expected == result){
+					cout << "PASSED" << endl;
+			} else {
+				cout << "FAILED" << endl;
+			}
+
+		}
+		
+		return 0;
+	}
+
+	int postfixToInfixTester(){
+
+		//IMPORTANT NOTE
+		//Test no 10 and 11 are supposed to passed since they are the most simplified version of the given expressions
+
+		cout << "Testing Postfix to Infix Conversions" << endl;
+		cout << "\nNote: Test no 10 and 11 are supposed to passed since they are the most simplified version of the given expressions." << endl;
+		bool show_details = false;
+		string result = "", expected = "";
+
+
+		for(int i=0; i<postfix_expressions.size(); i++){
+			
+			Expression test_expr(postfix_expressions.at(i));
+			result = test_expr.postfix_to_infix();
+			expected = infix_expressions.at(i);
+			if(show_details){
+				cout << "\n--- TEST NO " << i << "---" << endl;
+				cout << "Expression:\t" << postfix_expressions.at(i) << endl;
+				cout << "Expected:\t" << expected << endl;
+				cout << "Actual:\t\t" << result << endl;
+			}
+
+			cout << "Result:\t";
+
+			if(expected == result){
+					cout << "PASSED" << endl;
+			} else {
+				cout << "FAILED" << endl;
+			}
+
+		}
+		
+		return 0;
+	}
+ 
+	int postfixToPrefixTester(){
+
+
+		cout << "Testing Postfix to Prefix Conversions" << endl;
+
+		bool show_details = false;
+		string result = "", expected = "";
+
+
+		for(int i=0; i<prefix_expressions.size(); i++){
+			
+			Expression test_expr(postfix_expressions.at(i));
+			result = test_expr.postfix_to_prefix();
+			expected = prefix_expressions.at(i);
+			if(show_details){
+				cout << "\n--- TEST NO " << i << "---" << endl;
+				cout << "Expression:\t" << postfix_expressions.at(i) << endl;
+				cout << "Expected:\t" << expected << endl;
+				cout << "Actual:\t\t" << result << endl;
+			}
+
+			cout << "Result:\t";
+
+			if(expected == result){
+					cout << "PASSED" << endl;
+			} else {
+				cout << "FAILED" << endl;
+			}
+
+		}
+		
+		return 0;
+	}
+
+	int test_parser_and_converter(){
+
+		InfixExpressionTester();
+		PrefixExpressionTester();
+		PostfixExpressionTester();
+
+		infixToPrefixTester();
+		infixToPostfixTester();
+		prefixToInfixTester();
+		prefixToPostfixTester();
+		postfixToInfixTester();
+		postfixToPrefixTester();
+
+		return 0;
+	}
+
+	int get_equivalent_tester(){
+
+		for(int i=0; i<4; i++){
+			Expression test(infix_expressions.at(i));
+			test.get_equivalents();
+		}
+
+		for(int i=4; i<8; i++){
+			Expression test(prefix_expressions.at(i));
+			test.get_equivalents();
+		}
+
+		for(int i=8; i<12; i++){
+			Expression test(postfix_expressions.at(i));
+			test.get_equivalents();
+		}
+	
+		return 0;
+	}
+
+	int evaluator_tester(){
+
+		vector<string> expressions_to_test;
+		vector<string> expected_results;
+
+		expressions_to_test.push_back("6 2 3 + - 3 8 2 / + * 2 ^ 3 +");
+		expressions_to_test.push_back("+ 9 * 2 6");
+		expressions_to_test.push_back("- + 7 * 4 5 + 2 0");
+		expressions_to_test.push_back("- + 8 / 6 3 2");
+		expressions_to_test.push_back("( 5 + 10 ) / ( 20 / 4 )");
+
+		expected_results.push_back("52");
+		expected_results.push_back("21");
+		expected_results.push_back("25");
+		expected_results.push_back("8");
+		expected_results.push_back("3");
+
+		for(int i=0; i<expressions_to_test.size(); i++){
+			cout << endl;
+			Expression expr(expressions_to_test.at(i));
+			expr.evaluate();
+			cout << "Expected: " << expected_results.at(i) << endl;
+			cout << endl;
+		}
+
+		return 0;
+	}
+
+	//Feeds postfix and prefix expressions to StreamingEvaluator in chunks of 1, 2, 3, 5 and 1000 bytes, so numbers are
+	//cut at every position, and compares the answers with Expression. Erroneous streams must fail in every case.
+	int streaming_evaluator_tester(){
+
+		cout << "Testing Streaming Evaluation" << endl;
+
+		vector<string> expressions_to_test;
+		vector<ExpressionType> notations;
+		int chunk_sizes[] = {1, 2, 3, 5, 1000};
+
+		expressions_to_test.push_back("6 2 3 + - 3 8 2 / + * 2 ^ 3 +");
+		expressions_to_test.push_back("12.5 1e3 * 2.5e-2 /");
+		expressions_to_test.push_back("123456789 987654321 +");
+		expressions_to_test.push_back("1 0 /");
+		expressions_to_test.push_back("1 +");
+		expressions_to_test.push_back("1 2");
+		expressions_to_test.push_back("1. 2 +");
+		expressions_to_test.push_back("1e 2 +");
+		expressions_to_test.push_back("1 a +");
+		for(int i=0; i<(int) expressions_to_test.size(); i++){
+			notations.push_back(POSTFIX);
+		}
+		expressions_to_test.push_back("+ 9 * 2 6");
+		expressions_to_test.push_back("- + 7 * 4 5 + 2 0");
+		expressions_to_test.push_back("/ 1.5E+2 - 1000 999.75");
+		expressions_to_test.push_back("/ 1 0");
+		expressions_to_test.push_back("+ 1");
+		expressions_to_test.push_back("+ 1 2 3");
+		expressions_to_test.push_back("* 2 ( 3 )");
+		while(notations.size() < expressions_to_test.size()){
+			notations.push_back(PREFIX);
+		}
+
+		for(int i=0; i<(int) expressions_to_test.size(); i++){
+			Expression expr(expressions_to_test.at(i));
+			double expected = 0;
+			int expected_status = expr.evaluate(expected);
+			if(expr.get_type() != notations.at(i)){
+				expected_status = -1;
+			}
+
+			bool passed = true;
+			for(int k=0; k<5; k++){
+				StreamingEvaluator evaluator(notations.at(i));
+				string_view text = expressions_to_test.at(i);
+				for(int start=0; start<(int) text.length(); start += chunk_sizes[k]){
+					evaluator.feed(text.substr(start, chunk_sizes[k]));
+				}
+				double answer = 0;
+				int status = evaluator.finish(answer);
+				if((status == 0) != (expected_status == 0) || (status == 0 && answer != expected)){
+					passed = false;
+				}
+			}
+
+			cout << "Result:\t";
+			if(passed){
+				cout << "PASSED" << endl;
+			} else {
+				cout << "FAILED" << endl;
+			}
+		}
+
+		return 0;
+	}
+
+	int decimal_evaluator_tester(){
+
+		cout << "Testing Evaluation of Decimal Numbers" << endl;
+
+		vector<string> expressions_to_test;
+		vector<double> expected_results;
+
+		expressions_to_test.push_back("3.25 2 *");
+		expected_results.push_back(6.5);
+		expressions_to_test.push_back("7 / 2");
+		expected_results.push_back(3.5);
+		expressions_to_test.push_back("+ 1e9 1");
+		expected_results.push_back(1000000001);
+		expressions_to_test.push_back("2 ^ 40");
+		expected_results.push_back(1099511627776.0);
+		expressions_to_test.push_back("1.5e-3 * 1000");
+		expected_results.push_back(1.5);
+		expressions_to_test.push_back("3000000000 3000000000 +");
+		expected_results.push_back(6000000000.0);
+		//too small for a double, through a long run of zeros or a negative exponent, so they read as 0
+		expressions_to_test.push_back("0." + string(400, '0') + "1 + 1");
+		expected_results.push_back(1);
+		expressions_to_test.push_back("1e-400 + 1");
+		expected_results.push_back(1);
+		expressions_to_test.push_back("1e400 - 1");
+		expected_results.push_back(HUGE_VAL);
+
+		for(int i=0; i<(int) expressions_to_test.size(); i++){
+			Expression expr(expressions_to_test.at(i));
+			double answer;
+			int status = expr.evaluate(answer);
+
+			cout << "Result:\t";
+			if(status == 0 && answer == expected_results.at(i)){
+				cout << "PASSED" << endl;
+			} else {
+				cout << "FAILED" << endl;
+			}
+		}
+
+		return 0;
+	}
 
-	public:
+	int integer_evaluator_tester(){
 
-	ExpressionsTester(){
+		cout << "Testing Exact Integer Evaluation" << endl;
 
-		infix_expressions.push_back("A+B*C+D");
-		infix_expressions.push_back("(A+B)*(C+D)");
-		infix_expressions.push_back("A*B+C*D");
-		infix_expressions.push_back("A+B+C+D");
-		infix_expressions.push_back("(A+B)*C");
-		infix_expressions.push_back("A*B+C/D");
-		infix_expressions.push_back("A*(B+C)/D");
-		infix_expressions.push_back("a*(b+c/d)");
-		infix_expressions.push_back("a*(b+c)");
-		infix_expressions.push_back("a/b+c/d");
-		infix_expressions.push_back("((a+b)*c)-d");
-		infix_expressions.push_back("(a+(((b*c)-((d/(e^f))*g))*h))");
+		vector<string> expressions_to_test;
+		vector<string> expected_results;
 
-		prefix_expressions.push_back("++A*BCD");
-		prefix_expressions.push_back("*+AB+CD");
-		prefix_expressions.push_back("+*AB*CD");
-		prefix_expressions.push_back("+++ABCD");
-		prefix_expressions.push_back("*+ABC");
-		prefix_expressions.push_back("+*AB/CD");
-		prefix_expressions.push_back("/*A+BCD");
-		prefix_expressions.push_back("*a+b/cd");
-		prefix_expressions.push_back("*a+bc");
-		prefix_expressions.push_back("+/ab/cd");
-		prefix_expressions.push_back("-*+abcd");
-		prefix_expressions.push_back("+a*-*bc*/d^efgh");
+		expressions_to_test.push_back("2 ^ 64");
+		expected_results.push_back("18446744073709551616");
+		expressions_to_test.push_back("2 ^ 100 - 1");
+		expected_results.push_back("1267650600228229401496703205375");
+		expressions_to_test.push_back("99999999999999999999 99999999999999999999 *");
+		expected_results.push_back("9999999999999999999800000000000000000001");
+		expressions_to_test.push_back("/ 100000000000000000000 7");
+		expected_results.push_back("14285714285714285714");
+		expressions_to_test.push_back("( 123456789012345678901234567890 * 987654321098765432109876543210 + 55555 ) / 987654321098765432109876543210");
+		expected_results.push_back("123456789012345678901234567890");
+		expressions_to_test.push_back("5 - 12");
+		expected_results.push_back("-7");
+		expressions_to_test.push_back("0 7 - 2 /");
+		expected_results.push_back("-3");
+		expressions_to_test.push_back("2 ^ 4096 / 2 ^ 4095");
+		expected_results.push_back("2");
+		expressions_to_test.push_back("1 / 0");
+		expected_results.push_back("");
+		expressions_to_test.push_back("2.5 * 2");
+		expected_results.push_back("");
+
+		for(int i=0; i<(int) expressions_to_test.size(); i++){
+			Expression expr(expressions_to_test.at(i));
+			BigInteger answer;
+			int status = expr.evaluate_integer(answer);
 
-		postfix_expressions.push_back("ABC*+D+");
-		postfix_expressions.push_back("AB+CD+*");
-		postfix_expressions.push_back("AB*CD*+");
-		postfix_expressions.push_back("AB+C+D+");
-		postfix_expressions.push_back("AB+C*");
-		postfix_expressions.push_back("AB*CD/+");
-		postfix_expressions.push_back("ABC+*D/");
-		postfix_expressions.push_back("abcd/+*");
-		postfix_expressions.push_back("abc+*");
-		postfix_expressions.push_back("ab/cd/+");
-		postfix_expressions.push_back("ab+c*d-");
-		postfix_expressions.push_back("abc*def^/g*-h*+");
+			cout << "Result:\t";
+			if(status == 0 && answer.to_decimal() == expected_results.at(i)){
+				cout << "PASSED" << endl;
+			}
+			else if(status != 0 && expected_results.at(i) == ""){
+				cout << "PASSED" << endl;
+			} else {
+				cout << "FAILED" << endl;
+			}
+		}
+
+		//Numbers large enough for Karatsuba must multiply to the same product as the schoolbook method, and dividing
+		//a * b + r by b must give a back
+		BigInteger a, b, product, quotient;
+		BigInteger(3).power(BigInteger(20000), a);
+		BigInteger(7).power(BigInteger(9000), b);
+		b = b.add(BigInteger(12345));
+		product = a.multiply(b);
+
+		cout << "Result:\t";
+		if(product.equals(a.multiply_schoolbook(b))){
+			cout << "PASSED" << endl;
+		} else {
+			cout << "FAILED" << endl;
+		}
 
+		product.add(BigInteger(12344)).divide(b, quotient);
+		cout << "Result:\t";
+		if(quotient.equals(a)){
+			cout << "PASSED" << endl;
+		} else {
+			cout << "FAILED" << endl;
+		}
+
+		return 0;
 	}
 
-	int InfixExpressionTester(){
-		
-		cout << "Testing Infix Expression Parser" << endl;
+	int bound_evaluator_tester(){
 
-		bool show_details = false;
-		int expected, result;
+		cout << "Testing Evaluation with Variables" << endl;
 
-		expected = 0;
-		for(int i=0; i<infix_expressions.size(); i++){
-			InfixExpressionParser infix_tester(infix_expressions.at(i));
-			result = infix_tester.parse();
-			if(show_details){
-				cout << "\n--- POSITIVE TEST NO " << i << "---" << endl;
-				cout << "Expression:\t" << infix_expressions.at(i) << endl;
-				cout << "Expected:\t" ;
-				if(expected == 0){
-					cout << "VALID" << endl;
-				} else{
-					cout << "INVALID" << endl;
-				}
+		SymbolTable symbols;
+		symbols.add("A");
+		symbols.add("B");
+		symbols.add("C");
 
-				cout << "Actual:\t";
-				if(result == 0){
-					cout << "VALID" << endl;
-				} else{
-					cout << "INVALID" << endl;
+		double rows[2][3] = {{1, 2, 3}, {2.5, 0.5, 4}};
+
+		vector<string> expressions_to_test;
+		vector<double> expected_first_row;
+		vector<double> expected_second_row;
+
+		expressions_to_test.push_back("( A + B ) * C");
+		expected_first_row.push_back(9);
+		expected_second_row.push_back(12);
+		expressions_to_test.push_back("A B C * +");
+		expected_first_row.push_back(7);
+		expected_second_row.push_back(4.5);
+		expressions_to_test.push_back("- C / A B");
+		expected_first_row.push_back(2.5);
+		expected_second_row.push_back(-1);
+
+		for(int i=0; i<(int) expressions_to_test.size(); i++){
+			Expression expr(expressions_to_test.at(i));
+			double first, second;
+			int status = expr.compile(symbols);
+			status += expr.evaluate(rows[0], first);
+			status += expr.evaluate(rows[1], second);
+
+			cout << "Result:\t";
+			if(status == 0 && first == expected_first_row.at(i) && second == expected_second_row.at(i)){
+				cout << "PASSED" << endl;
+			} else {
+				cout << "FAILED" << endl;
+			}
+		}
+
+		Expression undefined("A + D");
+		string undefined_name;
+		int status = undefined.compile(symbols, undefined_name);
+		if(status == -1 && undefined_name != ""){
+			cout << "UNDEFINED VARIABLE " << undefined_name << endl;
+		}
+		cout << "Result:\t";
+		if(status == -1 && undefined_name == "D"){
+			cout << "PASSED" << endl;
+		} else {
+			cout << "FAILED" << endl;
+		}
+
+		return 0;
+	}
+
+	int column_evaluator_tester(){
+
+		cout << "Testing Column Evaluation" << endl;
+
+		SymbolTable symbols;
+		symbols.add("A");
+		symbols.add("B");
+		symbols.add("C");
+
+		//An odd row count so the part after the last full vector is checked too
+		int row_count = 2051;
+		vector<double> a(row_count), b(row_count), c(row_count), output(row_count);
+		const double* columns[3] = {a.data(), b.data(), c.data()};
+		for(int i=0; i<row_count; i++){
+			a[i] = i * 0.5;
+			b[i] = i % 7 + 1;
+			c[i] = i % 3;
+		}
+
+		vector<string> kernel_names;
+		kernel_names.push_back("scalar");
+		kernel_names.push_back("sse2");
+		kernel_names.push_back("avx2");
+
+		Expression expr("( A + B ) * C - A / B ^ 2");
+		expr.compile(symbols);
+		for(int k=0; k<(int) kernel_names.size(); k++){
+			ColumnKernels kernels = get_column_kernels(kernel_names.at(k));
+			expr.evaluate_columns(columns, row_count, output.data(), kernels);
+
+			bool matches = true;
+			for(int i=0; i<row_count; i++){
+				double row[3] = {a[i], b[i], c[i]};
+				double expected;
+				expr.evaluate(row, expected);
+				if(output[i] != expected){
+					matches = false;
 				}
 			}
-			cout << "Result:\t";
 
-			if(expected == result){
+			cout << "Result (" << kernels.name << "):\t";
+			if(matches){
 				cout << "PASSED" << endl;
-			} else{
+			} else {
 				cout << "FAILED" << endl;
 			}
+		}
+
+		return 0;
+	}
+
+	int classifier_tester(){
+
+		cout << "Testing Expression Classifier" << endl;
 
+		vector<string> expressions_to_test;
+		vector<ExpressionType> expected_types;
+
+		for(int i=0; i<(int) infix_expressions.size(); i++){
+			expressions_to_test.push_back(infix_expressions.at(i));
+			expected_types.push_back(INFIX);
+		}
+		for(int i=0; i<(int) prefix_expressions.size(); i++){
+			expressions_to_test.push_back(prefix_expressions.at(i));
+			expected_types.push_back(PREFIX);
+		}
+		for(int i=0; i<(int) postfix_expressions.size(); i++){
+			expressions_to_test.push_back(postfix_expressions.at(i));
+			expected_types.push_back(POSTFIX);
 		}
 
-		expected = 1;
-		for(int i=0; i<prefix_expressions.size(); i++){
+		expressions_to_test.push_back("6 2 3 + - 3 8 2 / + * 2 ^ 3 +");
+		expected_types.push_back(POSTFIX);
+		expressions_to_test.push_back("+ 9 * 2 6");
+		expected_types.push_back(PREFIX);
+		expressions_to_test.push_back("( 5 + 10 ) / ( 20 / 4 )");
+		expected_types.push_back(INFIX);
+		expressions_to_test.push_back("A");
+		expected_types.push_back(INFIX);
+		expressions_to_test.push_back("");
+		expected_types.push_back(ERROR_EXPR);
+		expressions_to_test.push_back("A+");
+		expected_types.push_back(ERROR_EXPR);
+		expressions_to_test.push_back("(A+B");
+		expected_types.push_back(ERROR_EXPR);
+		expressions_to_test.push_back("A+B)");
+		expected_types.push_back(ERROR_EXPR);
+		expressions_to_test.push_back("+A");
+		expected_types.push_back(ERROR_EXPR);
+		expressions_to_test.push_back("AB+C");
+		expected_types.push_back(ERROR_EXPR);
+		expressions_to_test.push_back("A+B$C");
+		expected_types.push_back(ERROR_EXPR);
+		//Spaces only separate tokens, so leading, trailing and repeated ones do not change the notation
+		expressions_to_test.push_back("  22 ");
+		expected_types.push_back(INFIX);
+		expressions_to_test.push_back("  (1 + 2)");
+		expected_types.push_back(INFIX);
+		expressions_to_test.push_back("2  + B");
+		expected_types.push_back(INFIX);
+		expressions_to_test.push_back("A  +  B");
+		expected_types.push_back(INFIX);
+		expressions_to_test.push_back(" 12 ");
+		expected_types.push_back(INFIX);
+		expressions_to_test.push_back("+  2 2 ");
+		expected_types.push_back(PREFIX);
+		expressions_to_test.push_back("+ A  B");
+		expected_types.push_back(PREFIX);
+		expressions_to_test.push_back("A B  +");
+		expected_types.push_back(POSTFIX);
+		expressions_to_test.push_back("1 2");
+		expected_types.push_back(ERROR_EXPR);
+
+		for(int i=0; i<(int) expressions_to_test.size(); i++){
+			Expression expr(expressions_to_test.at(i));
 
-			InfixExpressionParser infix_tester(prefix_expressions.at(i));
-			result = infix_tester.parse();
-			if(show_details){
-				cout << "\n--- FIRST NEGATIVE TEST NO " << i << " ---" << endl;
-				cout << "Expression:\t" << prefix_expressions.at(i) << endl;
-				cout << "Expected:\t" ;
-				if(expected == 0){
-					cout << "VALID" << endl;
-				} else{
-					cout << "INVALID" << endl;
+			cout << "Result:\t";
+			if(expr.get_type() == expected_types.at(i)){
+				cout << "PASSED" << endl;
+			} else {
+				cout << "FAILED" << endl;
+			}
+		}
+
+		return 0;
+	}
+
+	int batch_tester(){
+
+		cout << "Testing Batch Mode" << endl;
+
+		//The last line has no newline. Buffer sizes smaller than a line make lines span several reads, and with more
+		//than one thread every line becomes a chunk of its own.
+		string input = "1 + 2\n+ 1 2\r\n1 2 +\nA + 1\n1 / 0\n\n7 2 /";
+		string expected = "INFIX\t+ 1 2\t1 2 +\t3\nPREFIX\t1 + 2\t1 2 +\t3\nPOSTFIX\t1 + 2\t+ 1 2\t3\nINFIX\t+ A 1\tA 1 +\tERROR\n"
+			"INFIX\t/ 1 0\t1 0 /\tERROR\nERROR_EXPR\nPOSTFIX\t7 / 2\t/ 7 2\t3.5\n";
+
+		int buffer_sizes[] = {1, 4, 1 << 20};
+		int thread_counts[] = {1, 2, 4};
+		for(int i=0; i<3; i++){
+			for(int k=0; k<3; k++){
+				istringstream batch_input(input);
+				ostringstream batch_output;
+				process_batch(batch_input, batch_output, buffer_sizes[i], thread_counts[k]);
+
+				cout << "Result:\t";
+				if(batch_output.str() == expected){
+					cout << "PASSED" << endl;
+				} else {
+					cout << "FAILED" << endl;
 				}
-				cout << "Actual:\t";
-				if(result == 0){
-					cout << "VALID" << endl;
-				} else{
-					cout << "INVALID" << endl;
+			}
+		}
+
+#ifdef MAPPED_INPUT
+		string path = "batch_tester_input.txt";
+		ofstream file(path.c_str(), ios::binary);
+		file << input;
+		file.close();
+
+		for(int i=1; i<3; i++){
+			for(int k=0; k<2; k++){
+				ostringstream batch_output;
+				process_mapped_batch(path.c_str(), batch_output, buffer_sizes[i], thread_counts[k]);
+
+				cout << "Result:\t";
+				if(batch_output.str() == expected){
+					cout << "PASSED" << endl;
+				} else {
+					cout << "FAILED" << endl;
 				}
 			}
-			cout << "Result:\t";
+		}
+		remove(path.c_str());
+#endif
 
-			if(expected == result){
-				cout << "PASSED" << endl;
-			} else{
-				cout << "FAILED" << endl;
+		return 0;
+	}
+
+	//The same expression with every letter replaced by a number from 1 to 9.5, and a space between every two tokens
+	//so the digits of neighbouring operands stay apart. Batch mode evaluates these lines as well as converting them.
+	string with_numbers(string expression){
+		string numeric = "";
+		for(int i=0; i<(int) expression.length(); i++){
+			char c = expression[i];
+			if(c == ' '){
+				continue;
+			}
+			if(!numeric.empty()){
+				numeric += ' ';
 			}
+			if(char_token_type(c) == LETTER){
+				int letter = (c >= 'a') ? c - 'a' : c - 'A';
+				numeric += to_string(letter % 9 + 1);
+				if(letter % 2 == 1){
+					numeric += ".5";
+				}
+			} else {
+				numeric += c;
+			}
+		}
+		return numeric;
+	}
+
+	//Writes about size bytes of sample expressions, one per line, for the batch benchmarks. The samples are the
+	//expressions of this tester and one long prefix expression, each also with numbers in place of its letters so
+	//that half the lines are evaluated and not only converted.
+	int generate_batch_file(string path, long long size){
 
+		ofstream file(path.c_str(), ios::binary);
+		if(!file){
+			cout << "CANNOT OPEN " << path << endl;
+			return 1;
 		}
-		
-		expected = 1;
-		for(int i=0; i<postfix_expressions.size(); i++){
 
-			InfixExpressionParser infix_tester(postfix_expressions.at(i));
-			result = infix_tester.parse();
-			if(show_details){
-				cout << "\n--- SECOND NEGATIVE TEST NO " << i << " ---" << endl;
-				cout << "Expression:\t" << postfix_expressions.at(i) << endl;
-				cout << "Expected:\t" << "VALID" << endl;
-				cout << "Actual:\t";
-				if(result == 0){
-					cout << "VALID" << endl;
-				} else{
-					cout << "INVALID" << endl;
+		string sample = "";
+		for(int i=0; i<(int) infix_expressions.size(); i++){
+			sample += infix_expressions.at(i) + "\n";
+			sample += with_numbers(infix_expressions.at(i)) + "\n";
+			sample += prefix_expressions.at(i) + "\n";
+			sample += with_numbers(prefix_expressions.at(i)) + "\n";
+			sample += postfix_expressions.at(i) + "\n";
+			sample += with_numbers(postfix_expressions.at(i)) + "\n";
+		}
+		sample += "( 5 + 10 ) / ( 20 / 4 )\n";
+		sample += "3.25 2 * 7 / 1 +\n";
+		sample += "^ 2 - 10 * 2 3\n";
+		sample += generate_prefix(100) + "\n";
+		sample += with_numbers(generate_prefix(100)) + "\n";
+
+		string block = "";
+		while(block.length() < (1 << 20)){
+			block += sample;
+		}
+		for(long long written=0; written<size; written+=block.length()){
+			file.write(block.data(), block.length());
+		}
+
+		return 0;
+	}
+
+	int batch_scaling_benchmark(){
+
+		cout << "Benchmarking Batch Mode from 1 to " << thread::hardware_concurrency() << " Threads" << endl;
+
+		//Raise file_size for runs on bigger machines. The output is thrown away so only the conversion is measured.
+		string path = "batch_benchmark_input.txt";
+		long long file_size = 2LL << 30;
+		if(generate_batch_file(path, file_size) != 0){
+			return 1;
+		}
+
+		int max_threads = max(1, (int) thread::hardware_concurrency());
+		double single_thread_seconds = 0;
+		for(int thread_count=1; ; thread_count*=2){
+			thread_count = min(thread_count, max_threads);
+
+			ifstream file(path.c_str(), ios::binary);
+			ofstream discard;	//never opened, so whatever is written to it is dropped
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+			process_batch(file, discard, 1 << 20, thread_count);
+			chrono::steady_clock::time_point stop = chrono::steady_clock::now();
+
+			double seconds = chrono::duration<double>(stop - start).count();
+			if(thread_count == 1){
+				single_thread_seconds = seconds;
+			}
+			cout << thread_count << " threads:\t" << file_size / seconds / (1 << 20) << " MB/s\t";
+			cout << single_thread_seconds / seconds << "x" << endl;
+
+			if(thread_count == max_threads){
+				break;
+			}
+		}
+
+		remove(path.c_str());
+
+		return 0;
+	}
+
+	int mapped_input_benchmark(){
+
+		cout << "Benchmarking Buffered and Mapped Batch Input" << endl;
+
+		string path = "mapped_benchmark_input.txt";
+		long long file_size = 1LL << 30;
+		if(generate_batch_file(path, file_size) != 0){
+			return 1;
+		}
+
+		string modes[] = {"Buffered read", "Mapped file"};
+		for(int mode=0; mode<2; mode++){
+
+			//Samples the resident size while the batch runs, since the peak is what matters for huge files
+			long long baseline = resident_kilobytes(), peak = baseline;
+			bool running = true;
+			mutex peak_lock;
+			thread sampler([&](){
+				while(true){
+					{
+						lock_guard<mutex> lock(peak_lock);
+						if(!running){
+							return;
+						}
+						peak = max(peak, resident_kilobytes());
+					}
+					this_thread::sleep_for(chrono::milliseconds(5));
 				}
+			});
+
+			ofstream discard;	//never opened, so whatever is written to it is dropped
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+			if(mode == 0){
+				ifstream file(path.c_str(), ios::binary);
+				process_batch(file, discard, 1 << 20, 1);
+			} else {
+				process_mapped_batch(path.c_str(), discard, 1 << 20, 1);
 			}
-			cout << "Result:\t";
+			chrono::steady_clock::time_point stop = chrono::steady_clock::now();
 
-			if(expected == result){
+			{
+				lock_guard<mutex> lock(peak_lock);
+				running = false;
+			}
+			sampler.join();
+
+			double seconds = chrono::duration<double>(stop - start).count();
+			cout << modes[mode] << ":\t" << file_size / seconds / (1 << 20) << " MB/s\t";
+			cout << "peak RSS +" << (peak - baseline) / 1024 << " MB" << endl;
+		}
+
+		remove(path.c_str());
+
+		return 0;
+	}
+
+	int string_view_tester(){
+
+		cout << "Testing Expressions Read from string_view" << endl;
+
+		//Each view ends before the closing parentheses that follow it in buffer, which must not be read
+		string buffer = "(A+B)*C))) +A*BC))) AB+C*)))";
+		string_view views[] = {string_view(buffer.data(), 7), string_view(buffer.data() + 11, 5), string_view(buffer.data() + 20, 5)};
+		ExpressionType expected_types[] = {INFIX, PREFIX, POSTFIX};
+
+		for(int i=0; i<3; i++){
+			InfixExpressionParser infix_parser(views[i]);
+			PrefixExpressionParser prefix_parser(views[i]);
+			PostfixExpressionParser postfix_parser(views[i]);
+			bool parsers_agree = (infix_parser.parse() == 0) == (expected_types[i] == INFIX);
+			parsers_agree = parsers_agree && (prefix_parser.parse() == 0) == (expected_types[i] == PREFIX);
+			parsers_agree = parsers_agree && (postfix_parser.parse() == 0) == (expected_types[i] == POSTFIX);
+
+			Expression viewed(views[i]);
+			Expression owned(string(views[i]));
+			string viewed_output = "", owned_output = "";
+			viewed.append_equivalents(viewed_output);
+			owned.append_equivalents(owned_output);
+
+			cout << "Result:\t";
+			if(parsers_agree && viewed.get_type() == expected_types[i] && Expression::classify(views[i]) == expected_types[i]
+					&& viewed_output == owned_output){
 				cout << "PASSED" << endl;
-			} else{
+			} else {
 				cout << "FAILED" << endl;
 			}
+		}
+
+		//A copy must keep working after the Expression it was copied from is gone
+		Expression* original = new Expression(string("A+B*C"));
+		Expression copy(*original);
+		delete original;
+		string copy_output = "";
+		copy.append_equivalents(copy_output);
+
+		cout << "Result:\t";
+		if(copy_output == "INFIX\t+A*BC\tABC*+"){
+			cout << "PASSED" << endl;
+		} else {
+			cout << "FAILED" << endl;
+		}
+
+		return 0;
+	}
+
+	int allocation_benchmark(){
+
+		cout << "Benchmarking Heap Allocations per Expression" << endl;
+
+#ifdef COUNT_ALLOCATIONS
+		vector<string> corpus;
+		for(int i=0; i<infix_expressions.size(); i++){
+			corpus.push_back(infix_expressions.at(i));
+			corpus.push_back(prefix_expressions.at(i));
+			corpus.push_back(postfix_expressions.at(i));
+		}
+		corpus.push_back(generate_prefix(100));
+
+		//Run once first so that the classifier's reused token buffer has its final size
+		for(int i=0; i<corpus.size(); i++){
+			Expression::classify(corpus.at(i));
+		}
+
+		string methods[] = {"Parsers from string_view", "Expression::classify", "Expression from string_view", "Expression from string"};
+		int rounds = 1000;
+		int checksum = 0;
+		for(int method=0; method<4; method++){
+			long long allocations_before = allocation_count.load();
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+			for(int round=0; round<rounds; round++){
+				for(int i=0; i<corpus.size(); i++){
+					string_view input = corpus.at(i);
+					if(method == 0){
+						InfixExpressionParser infix_parser(input);
+						PrefixExpressionParser prefix_parser(input);
+						PostfixExpressionParser postfix_parser(input);
+						checksum += infix_parser.parse() + prefix_parser.parse() + postfix_parser.parse();
+					}
+					else if(method == 1){
+						checksum += Expression::classify(input);
+					}
+					else if(method == 2){
+						Expression expr(input);
+						checksum += expr.get_type();
+					} else {
+						Expression expr(corpus.at(i));
+						checksum += expr.get_type();
+					}
+				}
+			}
+			chrono::steady_clock::time_point stop = chrono::steady_clock::now();
+			long long allocations = allocation_count.load() - allocations_before;
+			double expressions = (double) rounds * corpus.size();
 
+			cout << methods[method] << ":\t" << allocations / expressions << " allocations\t";
+			cout << chrono::duration<double, nano>(stop - start).count() / expressions << " ns/expression" << endl;
 		}
 
+		if(checksum < 0){
+			cout << checksum << endl;
+		}
+#else
+		cout << "Build with -DCOUNT_ALLOCATIONS to count allocations" << endl;
+#endif
 
-	return 0;
+		return 0;
 	}
 
-	int PrefixExpressionTester(){
-		
-		cout << "Testing Prefix Expression Parser" << endl;
+	int lexer_benchmark(){
 
-		bool show_details = false;
-		int expected, result;
+		cout << "Benchmarking Character Classification (MB/s)" << endl;
 
-		expected = 1;
-		for(int i=0; i<infix_expressions.size(); i++){
-			PrefixExpressionParser prefix_tester(infix_expressions.at(i));
-			result = prefix_tester.parse();
-			if(show_details){
-				cout << "\n--- FIRST NEGATIVE TEST NO " << i << "---" << endl;
-				cout << "Expression:\t" << infix_expressions.at(i) << endl;
-				cout << "Expected:\t" ;
-				if(expected == 0){
-					cout << "VALID" << endl;
-				} else{
-					cout << "INVALID" << endl;
-				}
+		string text = generate_prefix(1 << 22);
+		int rounds = 10;
+		int checksum = 0;
+		chrono::steady_clock::time_point start, stop;
+		double megabytes = (double) rounds * text.length() / (1 << 20);
 
-				cout << "Actual:\t";
-				if(result == 0){
-					cout << "VALID" << endl;
-				} else{
-					cout << "INVALID" << endl;
-				}
+		start = chrono::steady_clock::now();
+		for(int round=0; round<rounds; round++){
+			for(int i=0; i<(int) text.length(); i++){
+				checksum += char_type_with_branches(text[i]);
 			}
-			cout << "Result:\t";
+		}
+		stop = chrono::steady_clock::now();
+		cout << "if/else chain:\t\t" << megabytes / chrono::duration<double>(stop - start).count() << endl;
 
-			if(expected == result){
-				cout << "PASSED" << endl;
-			} else{
-				cout << "FAILED" << endl;
+		start = chrono::steady_clock::now();
+		for(int round=0; round<rounds; round++){
+			for(int i=0; i<(int) text.length(); i++){
+				checksum += char_token_type(text[i]);
+			}
+		}
+		stop = chrono::steady_clock::now();
+		cout << "Table:\t\t\t" << megabytes / chrono::duration<double>(stop - start).count() << endl;
+
+		//Long expressions with short tokens and with long numbers and wide spacing. The masks gain the most where runs are long.
+		string samples[] = {"12345 + 678 * ( 90 - 1 ) / 23 ^ 4 - 3.25 * 1e9 + ", "123456789012345678 + 987654321098765432       *       "};
+		string sample_names[] = {"short tokens", "long runs"};
+		vector<Token> tokens;
+		string kernel_names[] = {"scalar", "sse2", "avx2"};
+		for(int sample=0; sample<2; sample++){
+			string long_expression = "";
+			while(long_expression.length() < text.length()){
+				long_expression += samples[sample];
+			}
+			long_expression += "1";
+			double expression_megabytes = (double) rounds * long_expression.length() / (1 << 20);
+
+			start = chrono::steady_clock::now();
+			for(int round=0; round<rounds; round++){
+				ExpressionLexer lexer(long_expression);
+				lexer.tokenize_per_character(tokens);
+				checksum += tokens.size();
+			}
+			stop = chrono::steady_clock::now();
+			cout << "Lexer per character, " << sample_names[sample] << ":\t" << expression_megabytes / chrono::duration<double>(stop - start).count() << endl;
+
+			for(int k=0; k<3; k++){
+				MaskKernel kernel = get_mask_kernel(kernel_names[k]);
+				start = chrono::steady_clock::now();
+				for(int round=0; round<rounds; round++){
+					ExpressionLexer lexer(long_expression);
+					lexer.tokenize_with_masks(tokens, kernel);
+					checksum += tokens.size();
+				}
+				stop = chrono::steady_clock::now();
+				cout << "Lexer masks " << kernel_names[k] << ", " << sample_names[sample] << ":\t";
+				cout << expression_megabytes / chrono::duration<double>(stop - start).count() << endl;
 			}
+		}
 
+		//The postfix parser reads a valid input to the end, so it lexes every byte
+		string postfix = "A";
+		while(postfix.length() < text.length()){
+			postfix += "B+";
+		}
+		start = chrono::steady_clock::now();
+		for(int round=0; round<rounds; round++){
+			PostfixExpressionParser parser(postfix);
+			checksum += parser.parse();
 		}
+		stop = chrono::steady_clock::now();
+		cout << "Parser lex():\t\t" << (double) rounds * postfix.length() / (1 << 20) / chrono::duration<double>(stop - start).count() << endl;
 
-		expected = 0;
-		for(int i=0; i<prefix_expressions.size(); i++){
+		if(checksum < 0){
+			cout << checksum << endl;
+		}
 
-			PrefixExpressionParser prefix_tester(prefix_expressions.at(i));
-			result = prefix_tester.parse();
-			if(show_details){
-				cout << "\n--- POSTIIVE TEST NO " << i << " ---" << endl;
-				cout << "Expression:\t" << prefix_expressions.at(i) << endl;
-				cout << "Expected:\t" ;
-				if(expected == 0){
-					cout << "VALID" << endl;
-				} else{
-					cout << "INVALID" << endl;
+		return 0;
+	}
+
+	int mask_lexer_tester(){
+
+		cout << "Testing Tokenizing with Character Masks" << endl;
+
+		//Random inputs from 1 to 1000 bytes with runs of digits and spaces that cross the 64 byte mask words, a byte
+		//above 127 and a '\0' now and then
+		vector<string> inputs;
+		string alphabet = "0123456789  ..eE+-*/^()_AbZ\t#";
+		unsigned int seed = 124;
+		for(int i=0; i<300; i++){
+			seed = seed * 1103515245 + 12345;
+			int length = 1 + (seed >> 8) % 1000;
+			string input = "";
+			while((int) input.length() < length){
+				seed = seed * 1103515245 + 12345;
+				int choice = (seed >> 8) % (alphabet.length() + 3);
+				if(choice < (int) alphabet.length()){
+					input += alphabet[choice];
 				}
-				cout << "Actual:\t";
-				if(result == 0){
-					cout << "VALID" << endl;
-				} else{
-					cout << "INVALID" << endl;
+				else if(choice == (int) alphabet.length()){
+					input += string(1 + (seed >> 20) % 80, '7');
+				}
+				else if(choice == (int) alphabet.length() + 1){
+					input += string(1 + (seed >> 20) % 80, ' ');
+				}
+				else if((seed >> 20) % 10 == 0){
+					input += (seed >> 24) % 2 == 0 ? '\0' : (char) 200;
 				}
 			}
-			cout << "Result:\t";
-
-			if(expected == result){
-				cout << "PASSED" << endl;
-			} else{
-				cout << "FAILED" << endl;
-			}
-
+			inputs.push_back(input);
 		}
-		
-		expected = 1;
-		for(int i=0; i<postfix_expressions.size(); i++){
 
-			PrefixExpressionParser prefix_tester(postfix_expressions.at(i));
-			result = prefix_tester.parse();
-			if(show_details){
-				cout << "\n--- SECOND NEGATIVE TEST NO " << i << " ---" << endl;
-				cout << "Expression:\t" << postfix_expressions.at(i) << endl;
-				cout << "Expected:\t" << "VALID" << endl;
-				cout << "Actual:\t";
-				if(result == 0){
-					cout << "VALID" << endl;
-				} else{
-					cout << "INVALID" << endl;
+		string kernel_names[] = {"scalar", "sse2", "avx2"};
+		for(int k=0; k<3; k++){
+			MaskKernel kernel = get_mask_kernel(kernel_names[k]);
+			bool same = true;
+			for(int i=0; i<(int) inputs.size(); i++){
+				vector<Token> expected, result;
+				ExpressionLexer lexer(inputs.at(i));
+				lexer.tokenize_per_character(expected);
+				lexer.tokenize_with_masks(result, kernel);
+				if(expected.size() != result.size()){
+					same = false;
+					continue;
+				}
+				for(int t=0; t<(int) expected.size(); t++){
+					if(expected[t].type != result[t].type || expected[t].offset != result[t].offset || expected[t].length != result[t].length){
+						same = false;
+					}
 				}
 			}
-			cout << "Result:\t";
 
-			if(expected == result){
+			cout << "Result:\t";
+			if(same){
 				cout << "PASSED" << endl;
-			} else{
+			} else {
 				cout << "FAILED" << endl;
 			}
-
 		}
 
-
-	return 0;
+		return 0;
 	}
 
-	int PostfixExpressionTester(){
-		
-		cout << "Testing Postfix Expression Parser" << endl;
+	//Feeds infix expressions to StreamingInfixConverter in chunks of 1, 2, 3, 5 and 1000 bytes and compares the output with Expression.
+	//Input that is not an infix expression must fail in every case.
+	int streaming_converter_tester(){
 
-		bool show_details = false;
-		int expected, result;
+		cout << "Testing Streaming Infix to Postfix Conversion" << endl;
 
-		expected = 1;
-		for(int i=0; i<infix_expressions.size(); i++){
-			PostfixExpressionParser postfix_tester(infix_expressions.at(i));
-			result = postfix_tester.parse();
-			if(show_details){
-				cout << "\n--- FIRST NEGATIVE TEST NO " << i << "---" << endl;
-				cout << "Expression:\t" << infix_expressions.at(i) << endl;
-				cout << "Expected:\t" ;
-				if(expected == 0){
-					cout << "VALID" << endl;
-				} else{
-					cout << "INVALID" << endl;
+		vector<string> expressions_to_test = infix_expressions;
+		int chunk_sizes[] = {1, 2, 3, 5, 1000};
+
+		expressions_to_test.push_back("12.5 * ( 3 + 4e2 ) - 7");
+		expressions_to_test.push_back("1.5E-3 ^ 2 / x");
+		expressions_to_test.push_back("1 2 + 3");
+		expressions_to_test.push_back("( A + B ) )");
+		expressions_to_test.push_back("( ( A + B )");
+		expressions_to_test.push_back("A + * B");
+		expressions_to_test.push_back("1. + 2");
+
+		for(int i=0; i<(int) expressions_to_test.size(); i++){
+			Expression expr(expressions_to_test.at(i));
+			string expected = expr.infix_to_postfix();
+			expected.erase(remove(expected.begin(), expected.end(), ' '), expected.end());
+
+			bool passed = true;
+			for(int k=0; k<5; k++){
+				StreamingInfixConverter converter;
+				string_view text = expressions_to_test.at(i);
+				string postfix = "";
+				int status = 0;
+				for(int start=0; start<(int) text.length(); start += chunk_sizes[k]){
+					status += converter.feed(text.substr(start, chunk_sizes[k]), postfix);
+				}
+				if(status == 0){
+					status = converter.finish(postfix);
 				}
 
-				cout << "Actual:\t";
-				if(result == 0){
-					cout << "VALID" << endl;
-				} else{
-					cout << "INVALID" << endl;
+				if((status == 0) != (expr.get_type() == INFIX)){
+					passed = false;
+				}
+				//Expression separates its output only when the input was, so spaces are left out of the comparison
+				postfix.erase(remove(postfix.begin(), postfix.end(), ' '), postfix.end());
+				if(status == 0 && postfix != expected){
+					passed = false;
 				}
 			}
-			cout << "Result:\t";
 
-			if(expected == result){
+			cout << "Result:\t";
+			if(passed){
 				cout << "PASSED" << endl;
-			} else{
+			} else {
 				cout << "FAILED" << endl;
 			}
-
 		}
 
-		expected = 1;
-		for(int i=0; i<prefix_expressions.size(); i++){
+		return 0;
+	}
 
-			PostfixExpressionParser postfix_tester(prefix_expressions.at(i));
-			result = postfix_tester.parse();
-			if(show_details){
-				cout << "\n--- SECOND NEGATIVE TEST NO " << i << " ---" << endl;
-				cout << "Expression:\t" << prefix_expressions.at(i) << endl;
-				cout << "Expected:\t" ;
-				if(expected == 0){
-					cout << "VALID" << endl;
-				} else{
-					cout << "INVALID" << endl;
+	//Feeds random text to StreamingClassifier in chunks of 1, 3 and 1000 bytes and checks the verdict against
+	//Expression::classify on the whole text.
+	int streaming_classifier_tester(){
+
+		cout << "Testing Streaming Classification" << endl;
+
+		string alphabet = "A12.5e+-*/^()  _E";
+		vector<string> inputs;
+		unsigned int seed = 124;
+		int chunk_sizes[] = {1, 3, 1000};
+
+		for(int i=0; i<3000; i++){
+			seed = seed * 1103515245 + 12345;
+			int length = 1 + (seed >> 16) % 12;
+			string input = "";
+			for(int k=0; k<length; k++){
+				seed = seed * 1103515245 + 12345;
+				input += alphabet[(seed >> 16) % alphabet.length()];
+			}
+			inputs.push_back(input);
+		}
+		inputs.insert(inputs.end(), infix_expressions.begin(), infix_expressions.end());
+		inputs.insert(inputs.end(), prefix_expressions.begin(), prefix_expressions.end());
+		inputs.insert(inputs.end(), postfix_expressions.begin(), postfix_expressions.end());
+
+		for(int k=0; k<3; k++){
+			bool passed = true;
+			for(int i=0; i<(int) inputs.size(); i++){
+				StreamingClassifier classifier;
+				string_view text = inputs.at(i);
+				for(int start=0; start<(int) text.length(); start += chunk_sizes[k]){
+					classifier.feed(text.substr(start, chunk_sizes[k]));
 				}
-				cout << "Actual:\t";
-				if(result == 0){
-					cout << "VALID" << endl;
-				} else{
-					cout << "INVALID" << endl;
+				if(classifier.finish() != Expression::classify(text)){
+					passed = false;
 				}
 			}
-			cout << "Result:\t";
 
-			if(expected == result){
+			cout << "Result:\t";
+			if(passed){
 				cout << "PASSED" << endl;
-			} else{
+			} else {
 				cout << "FAILED" << endl;
 			}
-
 		}
-		
-		expected = 0;
-		for(int i=0; i<postfix_expressions.size(); i++){
 
-			PostfixExpressionParser postfix_tester(postfix_expressions.at(i));
-			result = postfix_tester.parse();
-			if(show_details){
-				cout << "\n--- POSITIVE TEST NO " << i << " ---" << endl;
-				cout << "Expression:\t" << postfix_expressions.at(i) << endl;
-				cout << "Expected:\t" << "VALID" << endl;
-				cout << "Actual:\t";
-				if(result == 0){
-					cout << "VALID" << endl;
-				} else{
-					cout << "INVALID" << endl;
-				}
+		return 0;
+	}
+
+	int parentheses_tester(){
+
+		cout << "Testing Parentheses in Infix Conversions" << endl;
+
+		vector<string> expressions_to_test;
+		vector<string> expected_results;
+
+		expressions_to_test.push_back("-A-BC");
+		expected_results.push_back("A-(B-C)");
+		expressions_to_test.push_back("/A*BC");
+		expected_results.push_back("A/(B*C)");
+		expressions_to_test.push_back("*+AB-CD");
+		expected_results.push_back("(A+B)*(C-D)");
+		expressions_to_test.push_back("^A^BC");
+		expected_results.push_back("A^(B^C)");
+		expressions_to_test.push_back("AB^C^");
+		expected_results.push_back("A^B^C");
+		expressions_to_test.push_back("AB-CD--");
+		expected_results.push_back("A-B-(C-D)");
+
+		for(int i=0; i<(int) expressions_to_test.size(); i++){
+			Expression expr(expressions_to_test.at(i));
+			string result;
+			if(expr.get_type() == PREFIX){
+				result = expr.prefix_to_infix();
+			} else {
+				result = expr.postfix_to_infix();
 			}
-			cout << "Result:\t";
 
-			if(expected == result){
+			cout << "Result:\t";
+			if(result == expected_results.at(i)){
 				cout << "PASSED" << endl;
-			} else{
+			} else {
 				cout << "FAILED" << endl;
 			}
+		}
+
+		return 0;
+	}
 
+	int evaluate_benchmark(){
+
+		cout << "Benchmarking Repeated Evaluation (postfix with 1000 operators)" << endl;
+
+		string postfix = "1";
+		int rounds = 2000;
+		double answer, total = 0;
+		chrono::steady_clock::time_point start, stop;
+
+		for(int i=0; i<500; i++){
+			postfix += " 3 + 2 *";
+		}
+
+		start = chrono::steady_clock::now();
+		for(int i=0; i<rounds; i++){
+			Expression expr(postfix);
+			expr.evaluate(answer);
+			total += answer;
+		}
+		stop = chrono::steady_clock::now();
+		cout << "Parse and evaluate:\t" << chrono::duration<double, micro>(stop - start).count() / rounds << " us" << endl;
+
+		Expression expr(postfix);
+		expr.compile();
+		start = chrono::steady_clock::now();
+		for(int i=0; i<rounds; i++){
+			expr.evaluate(answer);
+			total += answer;
 		}
+		stop = chrono::steady_clock::now();
+		cout << "Run compiled program:\t" << chrono::duration<double, micro>(stop - start).count() / rounds << " us" << endl;
 
+		if(total < 0){
+			cout << total << endl;
+		}
 
-	return 0;
+		return 0;
 	}
 
-	int infixToPrefixTester(){
+	//One-shot evaluation of deep prefix chains, through the tree and a compiled program and straight from the tokens.
+	//Both include parsing the expression.
+	int direct_evaluation_benchmark(){
 
-		cout << "Testing Infix to Prefix Conversions" << endl;
-		bool show_details = false;
-		string result = "", expected = "";
+		cout << "Benchmarking Direct Evaluation of Deep Prefix Expressions (us/expression)" << endl;
 
+		bool same_answers = true;
+		double total = 0;
+		chrono::steady_clock::time_point start, stop;
 
-		for(int i=0; i<infix_expressions.size(); i++){
-			
-			Expression test_expr(infix_expressions.at(i));
-			result = test_expr.infix_to_prefix();
-			expected = prefix_expressions.at(i);
-			if(show_details){
-				cout << "\n--- TEST NO " << i << "---" << endl;
-				cout << "Expression:\t" << infix_expressions.at(i) << endl;
-				cout << "Expected:\t" << expected << endl;
-				cout << "Actual:\t\t" << result << endl;
+		for(int operator_count=1000; operator_count<=100000; operator_count*=10){
+			//left-deep: + + ... 1 2 2 ..., right-deep: + 1 + 1 ... 2
+			string prefixes[2];
+			prefixes[0] = "";
+			prefixes[1] = "";
+			for(int i=0; i<operator_count; i++){
+				prefixes[0] += "+ ";
+				prefixes[1] += "+ 1 ";
+			}
+			prefixes[0] += "1";
+			for(int i=0; i<operator_count; i++){
+				prefixes[0] += " 2";
 			}
+			prefixes[1] += "2";
+
+			string shape_names[] = {"Left-deep", "Right-deep"};
+			int rounds = 1000000 / operator_count;
+			for(int k=0; k<2; k++){
+				double compiled_answer = 0, direct_answer = 0;
+
+				start = chrono::steady_clock::now();
+				for(int round=0; round<rounds; round++){
+					Expression expr(prefixes[k]);
+					expr.compile();
+					expr.evaluate(NULL, compiled_answer);
+					total += compiled_answer;
+				}
+				stop = chrono::steady_clock::now();
+				cout << shape_names[k] << ", " << operator_count << " operators, tree and program:\t";
+				cout << chrono::duration<double, micro>(stop - start).count() / rounds << endl;
+
+				start = chrono::steady_clock::now();
+				for(int round=0; round<rounds; round++){
+					Expression expr(prefixes[k]);
+					expr.evaluate(direct_answer);
+					total += direct_answer;
+				}
+				stop = chrono::steady_clock::now();
+				cout << shape_names[k] << ", " << operator_count << " operators, direct:\t\t";
+				cout << chrono::duration<double, micro>(stop - start).count() / rounds << endl;
 
-			cout << "Result:\t";
+				if(compiled_answer != direct_answer){
+					same_answers = false;
+				}
+			}
+		}
 
-			if(expected == result){
-					cout << "PASSED" << endl;
-			} else {
-				cout << "FAILED" << endl;
+		cout << "Result:\t";
+		if(same_answers){
+			cout << "PASSED" << endl;
+		} else {
+			cout << "FAILED" << endl;
+		}
+		if(total < 0){
+			cout << total << endl;
+		}
+
+		return 0;
+	}
+
+	//Streams a 256 MB postfix expression, generated a 64 KB chunk at a time and never held whole, through
+	//StreamingEvaluator. The expression keeps returning to 1, so the answer is known and the stack stays shallow.
+	int streaming_evaluation_benchmark(){
+
+		cout << "Benchmarking Streaming Evaluation (256 MB postfix stream)" << endl;
+
+		string pattern = " 2.5 + 1.5e0 - 3 * 6 /";
+		string chunk = "1";
+		long long stream_size = 256LL << 20;
+		long long streamed = 0;
+		int max_depth = 0;
+		StreamingEvaluator evaluator(POSTFIX);
+
+		while(chunk.length() < (1 << 16)){
+			chunk += pattern;
+		}
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		while(streamed < stream_size){
+			evaluator.feed(chunk);
+			max_depth = max(max_depth, evaluator.depth());
+			streamed += chunk.length();
+			//every later chunk continues the expression instead of starting a new one
+			if(chunk[0] == '1'){
+				chunk.erase(0, 1);
+			}
+		}
+		double answer = 0;
+		int status = evaluator.finish(answer);
+		chrono::steady_clock::time_point stop = chrono::steady_clock::now();
+
+		cout << "MB/s:\t" << streamed / 1048576.0 / chrono::duration<double>(stop - start).count() << endl;
+		cout << "Deepest stack between chunks:\t" << max_depth << endl;
+		cout << "Result:\t";
+		if(status == 0 && answer == 1){
+			cout << "PASSED" << endl;
+		} else {
+			cout << "FAILED" << endl;
+		}
+
+		return 0;
+	}
+
+	int integer_evaluation_benchmark(){
+
+		cout << "Benchmarking Exact Integer Evaluation" << endl;
+
+		vector<string> expressions_to_time;
+		vector<int> rounds;
+		chrono::steady_clock::time_point start, stop;
+		int checksum = 0;
+
+		expressions_to_time.push_back("2 ^ 4096");
+		rounds.push_back(2000);
+		expressions_to_time.push_back("2 ^ 4096 * 3 ^ 4096 - 5 ^ 4096 / 7 ^ 1024");
+		rounds.push_back(200);
+		expressions_to_time.push_back("3 ^ 200000");
+		rounds.push_back(5);
+
+		for(int i=0; i<(int) expressions_to_time.size(); i++){
+			Expression expr(expressions_to_time.at(i));
+			BigInteger answer;
+			start = chrono::steady_clock::now();
+			for(int k=0; k<rounds.at(i); k++){
+				expr.evaluate_integer(answer);
+				checksum += answer.limb_count();
 			}
+			stop = chrono::steady_clock::now();
+			cout << expressions_to_time.at(i) << ":\t" << chrono::duration<double, micro>(stop - start).count() / rounds.at(i) << " us" << endl;
+		}
+
+		//The squarings in 3 ^ 200000 are where Karatsuba pays off
+		BigInteger large;
+		BigInteger(3).power(BigInteger(100000), large);
+
+		start = chrono::steady_clock::now();
+		checksum += large.multiply(large).limb_count();
+		stop = chrono::steady_clock::now();
+		cout << "Karatsuba square of " << large.limb_count() << " limbs:\t" << chrono::duration<double, milli>(stop - start).count() << " ms" << endl;
 
+		start = chrono::steady_clock::now();
+		checksum += large.multiply_schoolbook(large).limb_count();
+		stop = chrono::steady_clock::now();
+		cout << "Schoolbook square of " << large.limb_count() << " limbs:\t" << chrono::duration<double, milli>(stop - start).count() << " ms" << endl;
+
+		if(checksum < 0){
+			cout << checksum << endl;
 		}
-		
+
 		return 0;
 	}
 
-	int infixToPostfixTester(){
+	int bound_evaluation_benchmark(){
 
-		cout << "Testing Infix to Postfix Conversions" << endl;
-		bool show_details = false;
-		string result = "", expected = "";
+		cout << "Benchmarking Evaluation over Records (( A + B ) * C - A / 2)" << endl;
 
+		SymbolTable symbols;
+		symbols.add("A");
+		symbols.add("B");
+		symbols.add("C");
 
-		for(int i=0; i<infix_expressions.size(); i++){
-			
-			Expression test_expr(infix_expressions.at(i));
-			result = test_expr.infix_to_postfix();
-			expected = postfix_expressions.at(i);
-			if(show_details){
-				cout << "\n--- TEST NO " << i << "---" << endl;
-				cout << "Expression:\t" << infix_expressions.at(i) << endl;
-				cout << "Expected:\t" << expected << endl;
-				cout << "Actual:\t\t" << result << endl;
-			}
+		int row_count = 1000000;
+		vector<double> rows(3 * row_count);
+		for(int i=0; i<row_count; i++){
+			rows[3 * i] = i % 97;
+			rows[3 * i + 1] = i % 89;
+			rows[3 * i + 2] = i % 83;
+		}
 
-			cout << "Result:\t";
+		double answer, total = 0;
+		chrono::steady_clock::time_point start, stop;
 
-			if(expected == result){
-					cout << "PASSED" << endl;
-			} else {
-				cout << "FAILED" << endl;
-			}
+		start = chrono::steady_clock::now();
+		Expression expr("( A + B ) * C - A / 2");
+		expr.compile(symbols);
+		for(int i=0; i<row_count; i++){
+			expr.evaluate(&rows[3 * i], answer);
+			total += answer;
+		}
+		stop = chrono::steady_clock::now();
+		cout << "Compiled once:\t\t" << row_count / chrono::duration<double>(stop - start).count() << " rows/sec" << endl;
+
+		int reparsed_count = row_count / 10;
+		start = chrono::steady_clock::now();
+		for(int i=0; i<reparsed_count; i++){
+			string a = to_string((int) rows[3 * i]);
+			Expression reparsed("( " + a + " + " + to_string((int) rows[3 * i + 1]) + " ) * " + to_string((int) rows[3 * i + 2]) + " - " + a + " / 2");
+			reparsed.evaluate(answer);
+			total += answer;
+		}
+		stop = chrono::steady_clock::now();
+		cout << "Parsed per record:\t" << reparsed_count / chrono::duration<double>(stop - start).count() << " rows/sec" << endl;
 
+		if(total < 0){
+			cout << total << endl;
 		}
-		
+
 		return 0;
 	}
 
-	int prefixToInfixTester(){
+	int column_evaluation_benchmark(){
 
-		//IMPORTANT NOTE
-		//Test no 10 and 11 are supposed to passed since they are the most simplified version of the given expressions
+		cout << "Benchmarking Column Evaluation (( A + B ) * C - A / B)" << endl;
 
-		cout << "Testing Prefix to Infix Conversions" << endl;
-		cout << "\nNote: Test no 10 and 11 are supposed to passed since they are the most simplified version of the given expressions." << endl;
-		bool show_details = false;
-		string result = "", expected = "";
+		SymbolTable symbols;
+		symbols.add("A");
+		symbols.add("B");
+		symbols.add("C");
 
+		int row_count = 1000000;
+		int rounds = 10;
+		vector<double> a(row_count), b(row_count), c(row_count), rows(3 * row_count), output(row_count);
+		const double* columns[3] = {a.data(), b.data(), c.data()};
+		for(int i=0; i<row_count; i++){
+			a[i] = rows[3 * i] = i % 97;
+			b[i] = rows[3 * i + 1] = i % 89 + 1;
+			c[i] = rows[3 * i + 2] = i % 83;
+		}
 
-		for(int i=0; i<prefix_expressions.size(); i++){
-			
-			Expression test_expr(prefix_expressions.at(i));
-			result = test_expr.prefix_to_infix();
-			expected = infix_expressions.at(i);
-			if(show_details){
-				cout << "\n--- TEST NO " << i << "---" << endl;
-				cout << "Expression:\t" << prefix_expressions.at(i) << endl;
-				cout << "Expected:\t" << expected << endl;
-				cout << "Actual:\t\t" << result << endl;
+		Expression expr("( A + B ) * C - A / B");
+		expr.compile(symbols);
+		chrono::steady_clock::time_point start, stop;
+
+		start = chrono::steady_clock::now();
+		for(int round=0; round<rounds; round++){
+			for(int i=0; i<row_count; i++){
+				expr.evaluate(&rows[3 * i], output[i]);
 			}
+		}
+		stop = chrono::steady_clock::now();
+		cout << "Per row:\t" << (double) rounds * row_count / chrono::duration<double>(stop - start).count() << " rows/sec" << endl;
+
+		vector<string> kernel_names;
+		kernel_names.push_back("scalar");
+		kernel_names.push_back("sse2");
+		kernel_names.push_back("avx2");
+		for(int k=0; k<(int) kernel_names.size(); k++){
+			ColumnKernels kernels = get_column_kernels(kernel_names.at(k));
+			if(kernels.name != kernel_names.at(k)){
+				cout << kernel_names.at(k) << ":\tnot supported on this CPU" << endl;
+				continue;
+			}
+			start = chrono::steady_clock::now();
+			for(int round=0; round<rounds; round++){
+				expr.evaluate_columns(columns, row_count, output.data(), kernels);
+			}
+			stop = chrono::steady_clock::now();
+			cout << "Columns, " << kernels.name << ":\t" << (double) rounds * row_count / chrono::duration<double>(stop - start).count() << " rows/sec" << endl;
+		}
 
-			cout << "Result:\t";
+		return 0;
+	}
 
-			if(expected == result){
-					cout << "PASSED" << endl;
+	//Parses expressions nested ten million deep, which overflowed the call stack when the parsers recursed,
+	//then checks that set_max_depth rejects an input one level past the limit and accepts one at it.
+	int deep_expression_benchmark(){
+
+		cout << "Benchmarking Deep Expressions (10000000 levels)" << endl;
+
+		int depth = 10000000;
+		int limit = 1000;
+		chrono::steady_clock::time_point start, stop;
+		string prefix = string(depth, '+') + string(depth + 1, 'A');
+		string infix = string(depth, '(') + "A" + string(depth, ')');
+		int prefix_result, infix_result;
+
+		start = chrono::steady_clock::now();
+		PrefixExpressionParser prefix_parser(prefix);
+		prefix_result = prefix_parser.parse();
+		stop = chrono::steady_clock::now();
+		cout << "Prefix:\t" << chrono::duration<double, milli>(stop - start).count() << " ms" << endl;
+
+		start = chrono::steady_clock::now();
+		InfixExpressionParser infix_parser(infix);
+		infix_result = infix_parser.parse();
+		stop = chrono::steady_clock::now();
+		cout << "Infix:\t" << chrono::duration<double, milli>(stop - start).count() << " ms" << endl;
+
+		cout << "Result:\t";
+		if(prefix_result == 0 && infix_result == 0){
+			cout << "PASSED" << endl;
+		} else {
+			cout << "FAILED" << endl;
+		}
+
+		for(int extra=0; extra<2; extra++){
+			//the parsers keep a view of their input, so the text has to outlive them
+			string shallow_prefix = string(limit + extra, '+') + string(limit + extra + 1, 'A');
+			string shallow_infix = string(limit + extra, '(') + "A" + string(limit + extra, ')');
+			PrefixExpressionParser limited_prefix(shallow_prefix);
+			InfixExpressionParser limited_infix(shallow_infix);
+			limited_prefix.set_max_depth(limit);
+			limited_infix.set_max_depth(limit);
+
+			cout << "Result:\t";
+			if(limited_prefix.parse() == extra && limited_infix.parse() == extra){
+				cout << "PASSED" << endl;
 			} else {
 				cout << "FAILED" << endl;
 			}
-
 		}
-		
+
 		return 0;
 	}
 
-	int prefixToPostfixTester(){
+	//Builds Expressions nested exactly at a limit of 1000 and one level past it in each notation. The one at the limit
+	//keeps its notation and the one past it is an ERROR, while the default limit still takes both.
+	int depth_limit_tester(){
 
+		cout << "Testing Depth Limit" << endl;
 
-		cout << "Testing Prefix to Postfix Conversions" << endl;
+		int limit = 1000;
+		ExpressionType expected_types[3] = {PREFIX, INFIX, POSTFIX};
 
-		bool show_details = false;
-		string result = "", expected = "";
+		for(int extra=0; extra<2; extra++){
+			string inputs[3] = {
+				string(limit + extra, '+') + string(limit + extra + 1, 'A'),
+				string(limit + extra, '(') + "A" + string(limit + extra, ')'),
+				string(limit + extra + 1, 'A') + string(limit + extra, '+')
+			};
 
+			for(int i=0; i<3; i++){
+				Expression limited(inputs[i], limit);
+				Expression unlimited(inputs[i]);
+				ExpressionType expected = expected_types[i];
+				if(extra == 1){
+					expected = ERROR_EXPR;
+				}
 
-		for(int i=0; i<prefix_expressions.size(); i++){
-			
-			Expression test_expr(prefix_expressions.at(i));
-			result = test_expr.prefix_to_postfix();
-			expected = postfix_expressions.at(i);
-			if(show_details){
-				cout << "\n--- TEST NO " << i << "---" << endl;
-				cout << "Expression:\t" << prefix_expressions.at(i) << endl;
-				cout << "Expected:\t" << expected << endl;
-				cout << "Actual:\t\t" << result << endl;
+				cout << "Input:\t" << inputs[i].substr(0, 8) << "... (" << limit + extra << " levels)" << endl;
+				cout << "Result:\t";
+				if(limited.get_type() == expected && unlimited.get_type() == expected_types[i]){
+					cout << "PASSED" << endl;
+				} else {
+					cout << "FAILED" << endl;
+				}
 			}
+		}
 
-			cout << "Result:\t";
+		return 0;
+	}
 
-			if(expected == result){
-					cout << "PASSED" << endl;
-			} else {
-				cout << "FAILED" << endl;
-			}
+	//Converts a 256 MB infix expression, generated a 64 KB chunk at a time and never held whole, with
+	//StreamingInfixConverter. Memory should stay flat however long the expression gets.
+	int streaming_conversion_benchmark(){
 
+		cout << "Benchmarking Streaming Infix to Postfix Conversion (256 MB infix stream)" << endl;
+
+		string pattern = " + ( B * C - 12.5 ) / E ^ 3";
+		string chunk = "A";
+		string postfix;
+		long long stream_size = 256LL << 20;
+		long long streamed = 0, written = 0;
+		int max_depth = 0;
+		StreamingInfixConverter converter;
+		int status = 0;
+
+		while(chunk.length() < (1 << 16)){
+			chunk += pattern;
 		}
-		
+		long long baseline = resident_kilobytes(), peak = baseline;
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		while(streamed < stream_size){
+			status += converter.feed(chunk, postfix);
+			max_depth = max(max_depth, converter.depth());
+			streamed += chunk.length();
+			written += postfix.length();
+			postfix.clear();
+			peak = max(peak, resident_kilobytes());
+			//every later chunk continues the expression instead of starting a new one
+			if(chunk[0] == 'A'){
+				chunk.erase(0, 1);
+			}
+		}
+		status += converter.finish(postfix);
+		written += postfix.length();
+		chrono::steady_clock::time_point stop = chrono::steady_clock::now();
+
+		cout << "MB/s:\t" << streamed / 1048576.0 / chrono::duration<double>(stop - start).count() << endl;
+		cout << "Postfix MB written:\t" << written / 1048576.0 << endl;
+		cout << "Deepest stack between chunks:\t" << max_depth << endl;
+		cout << "Resident KB growth:\t" << peak - baseline << endl;
+		cout << "Result:\t";
+		if(status == 0){
+			cout << "PASSED" << endl;
+		} else {
+			cout << "FAILED" << endl;
+		}
+
 		return 0;
 	}
 
-	int postfixToInfixTester(){
-
-		//IMPORTANT NOTE
-		//Test no 10 and 11 are supposed to passed since they are the most simplified version of the given expressions
+	int arena_benchmark(){
 
-		cout << "Testing Postfix to Infix Conversions" << endl;
-		cout << "\nNote: Test no 10 and 11 are supposed to passed since they are the most simplified version of the given expressions." << endl;
-		bool show_details = false;
-		string result = "", expected = "";
+		cout << "Benchmarking Tree Allocation (build, walk and free a 100001 node tree)" << endl;
 
+		string prefix = generate_prefix(50000);
+		string expected = prefix_to_postfix_with_strings(prefix);
+		int rounds = 20;
+		chrono::steady_clock::time_point start, stop;
 
-		for(int i=0; i<postfix_expressions.size(); i++){
-			
-			Expression test_expr(postfix_expressions.at(i));
-			result = test_expr.postfix_to_infix();
-			expected = infix_expressions.at(i);
-			if(show_details){
-				cout << "\n--- TEST NO " << i << "---" << endl;
-				cout << "Expression:\t" << postfix_expressions.at(i) << endl;
-				cout << "Expected:\t" << expected << endl;
-				cout << "Actual:\t\t" << result << endl;
+		start = chrono::steady_clock::now();
+		for(int i=0; i<rounds; i++){
+			if(prefix_to_postfix_with_strings(prefix) != expected){
+				cout << "stack<string> result differs" << endl;
 			}
+		}
+		stop = chrono::steady_clock::now();
+		cout << "stack<string>:\t" << chrono::duration<double, milli>(stop - start).count() / rounds << " ms" << endl;
 
-			cout << "Result:\t";
-
-			if(expected == result){
-					cout << "PASSED" << endl;
-			} else {
-				cout << "FAILED" << endl;
+		start = chrono::steady_clock::now();
+		for(int i=0; i<rounds; i++){
+			if(prefix_to_postfix_with_pointers(prefix) != expected){
+				cout << "Node per allocation result differs" << endl;
 			}
+		}
+		stop = chrono::steady_clock::now();
+		cout << "Node per new:\t" << chrono::duration<double, milli>(stop - start).count() / rounds << " ms" << endl;
 
+		start = chrono::steady_clock::now();
+		for(int i=0; i<rounds; i++){
+			if(prefix_to_postfix_with_arena(prefix) != expected){
+				cout << "Arena result differs" << endl;
+			}
 		}
-		
+		stop = chrono::steady_clock::now();
+		cout << "Arena:\t\t" << chrono::duration<double, milli>(stop - start).count() / rounds << " ms" << endl;
+
 		return 0;
 	}
- 
-	int postfixToPrefixTester(){
 
+	//Builds the trees of the postfix test expressions, repeated a million times, from their text. The classifier
+	//alone, the classifier followed by the stack walk build_tree used to do, and Expression, which checks and builds
+	//in one pass with parse_postfix after parse_infix gives up within two tokens, are timed against each other. Each
+	//row lexes into a fresh token buffer and tree, as an Expression does.
+	int postfix_conversion_benchmark(){
+
+		cout << "Benchmarking Postfix Trees (ns/expression)" << endl;
+
+		int rounds = 1000000;
+		string row_names[] = {"Classify only:\t\t", "Classify, then build:\t", "parse_postfix:\t\t"};
+		long long checksum = 0;
+
+		for(int row=0; row<3; row++){
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+			for(int round=0; round<rounds; round++){
+				for(int i=0; i<(int) postfix_expressions.size(); i++){
+					if(row == 0){
+						vector<Token> tokens;
+						ExpressionLexer lexer(postfix_expressions.at(i));
+						lexer.tokenize(tokens);
+						ExpressionClassifier classifier(tokens);
+						checksum += classifier.classify();
+					}
+					else if(row == 1){
+						vector<Token> tokens;
+						ExpressionArena arena;
+						checksum += build_postfix_in_two_passes(postfix_expressions.at(i), tokens, arena);
+					} else {
+						Expression expr((string_view) postfix_expressions.at(i));
+						checksum += expr.get_type();
+					}
+				}
+			}
+			chrono::steady_clock::time_point stop = chrono::steady_clock::now();
+			cout << row_names[row] << chrono::duration<double, nano>(stop - start).count() / ((double) rounds * postfix_expressions.size()) << endl;
+		}
+		if(checksum < 0){
+			cout << checksum << endl;
+		}
 
-		cout << "Testing Postfix to Prefix Conversions" << endl;
+		return 0;
+	}
 
-		bool show_details = false;
-		string result = "", expected = "";
+	//Converts prefix chains of 10^4 to 10^6 operators to infix. A left chain needs no parentheses and a right chain
+	//needs a pair for every operator. The time per operator stays flat when the emitter is linear.
+	int infix_emission_benchmark(){
 
+		cout << "Benchmarking Infix Emission (ns/operator)" << endl;
 
-		for(int i=0; i<prefix_expressions.size(); i++){
-			
-			Expression test_expr(postfix_expressions.at(i));
-			result = test_expr.postfix_to_prefix();
-			expected = prefix_expressions.at(i);
-			if(show_details){
-				cout << "\n--- TEST NO " << i << "---" << endl;
-				cout << "Expression:\t" << postfix_expressions.at(i) << endl;
-				cout << "Expected:\t" << expected << endl;
-				cout << "Actual:\t\t" << result << endl;
+		Expression left_sample("+++abcd"), right_sample("+a+b+cd");
+		cout << "Result:\t";
+		if(left_sample.prefix_to_infix() == "a+b+c+d" && right_sample.prefix_to_infix() == "a+(b+(c+d))"){
+			cout << "PASSED" << endl;
+		} else {
+			cout << "FAILED" << endl;
+		}
+
+		long long checksum = 0;
+		for(int operator_count=10000; operator_count<=1000000; operator_count*=10){
+			string left_chain = string(operator_count, '+');
+			string right_chain = "";
+			for(int i=0; i<=operator_count; i++){
+				left_chain += (char) ('a' + i % 26);
 			}
+			for(int i=0; i<operator_count; i++){
+				right_chain += '+';
+				right_chain += (char) ('a' + i % 26);
+			}
+			right_chain += 'z';
+
+			string chains[] = {left_chain, right_chain};
+			string chain_names[] = {"Left chain", "Right chain"};
+			for(int k=0; k<2; k++){
+				Expression expr(chains[k]);
+				chrono::steady_clock::time_point start = chrono::steady_clock::now();
+				checksum += expr.prefix_to_infix().length();
+				chrono::steady_clock::time_point stop = chrono::steady_clock::now();
+				cout << chain_names[k] << ", " << operator_count << " operators:\t";
+				cout << chrono::duration<double, nano>(stop - start).count() / operator_count << endl;
+
+				if(operator_count == 10000){
+					start = chrono::steady_clock::now();
+					checksum += prefix_to_infix_with_strings(chains[k]).length();
+					stop = chrono::steady_clock::now();
+					cout << chain_names[k] << ", " << operator_count << " operators, rescanning strings:\t";
+					cout << chrono::duration<double, nano>(stop - start).count() / operator_count << endl;
+				}
+			}
+		}
+		if(checksum < 0){
+			cout << checksum << endl;
+		}
 
-			cout << "Result:\t";
+		return 0;
+	}
 
-			if(expected == result){
-					cout << "PASSED" << endl;
-			} else {
-				cout << "FAILED" << endl;
+	//Converts left-deep and right-deep trees of 10^4 to 10^6 operators between prefix and postfix. The operand
+	//strings of the old conversions are copied once per enclosing operator, which a deep tree makes quadratic.
+	int skewed_conversion_benchmark(){
+
+		cout << "Benchmarking Prefix and Postfix Conversion of Skewed Trees (ns/operator)" << endl;
+
+		long long checksum = 0;
+		for(int operator_count=10000; operator_count<=1000000; operator_count*=10){
+			//left-deep: ++...+abc... and ab+c+..., right-deep: +a+b...z and ...abc...z++
+			string prefixes[2], postfixes[2];
+			prefixes[0] = string(operator_count, '+');
+			postfixes[0] = "a";
+			prefixes[1] = "";
+			postfixes[1] = "";
+			for(int i=0; i<operator_count; i++){
+				char operand = 'a' + i % 26;
+				prefixes[0] += operand;
+				postfixes[0] += operand;
+				postfixes[0] += '+';
+				prefixes[1] += '+';
+				prefixes[1] += operand;
+				postfixes[1] += operand;
+			}
+			prefixes[0] += 'z';
+			prefixes[1] += 'z';
+			postfixes[1] += 'z' + string(operator_count, '+');
+
+			string shape_names[] = {"Left-deep", "Right-deep"};
+			for(int k=0; k<2; k++){
+				Expression prefix_expr(prefixes[k]), postfix_expr(postfixes[k]);
+				chrono::steady_clock::time_point start = chrono::steady_clock::now();
+				checksum += prefix_expr.prefix_to_postfix().length();
+				chrono::steady_clock::time_point middle = chrono::steady_clock::now();
+				checksum += postfix_expr.postfix_to_prefix().length();
+				chrono::steady_clock::time_point stop = chrono::steady_clock::now();
+				cout << shape_names[k] << ", " << operator_count << " operators, prefix to postfix:\t";
+				cout << chrono::duration<double, nano>(middle - start).count() / operator_count << endl;
+				cout << shape_names[k] << ", " << operator_count << " operators, postfix to prefix:\t";
+				cout << chrono::duration<double, nano>(stop - middle).count() / operator_count << endl;
+
+				if(operator_count == 10000){
+					start = chrono::steady_clock::now();
+					checksum += prefix_to_postfix_with_strings(prefixes[k]).length();
+					middle = chrono::steady_clock::now();
+					checksum += postfix_to_prefix_with_strings(postfixes[k]).length();
+					stop = chrono::steady_clock::now();
+					cout << shape_names[k] << ", " << operator_count << " operators, strings, prefix to postfix:\t";
+					cout << chrono::duration<double, nano>(middle - start).count() / operator_count << endl;
+					cout << shape_names[k] << ", " << operator_count << " operators, strings, postfix to prefix:\t";
+					cout << chrono::duration<double, nano>(stop - middle).count() / operator_count << endl;
+				}
 			}
-
 		}
-		
+		if(checksum < 0){
+			cout << checksum << endl;
+		}
+
 		return 0;
 	}
 
-	int test_parser_and_converter(){
+	int evaluate_type_benchmark(){
 
-		InfixExpressionTester();
-		PrefixExpressionTester();
-		PostfixExpressionTester();
+		cout << "Benchmarking Notation Detection" << endl;
 
-		infixToPrefixTester();
-		infixToPostfixTester();
-		prefixToInfixTester();
-		prefixToPostfixTester();
-		postfixToInfixTester();
-		postfixToPrefixTester();
+		vector<string> short_corpus;
+		vector<string> long_postfix_corpus;
+		string long_postfix = "A";
+
+		short_corpus.insert(short_corpus.end(), infix_expressions.begin(), infix_expressions.end());
+		short_corpus.insert(short_corpus.end(), prefix_expressions.begin(), prefix_expressions.end());
+		short_corpus.insert(short_corpus.end(), postfix_expressions.begin(), postfix_expressions.end());
+
+		for(int i=0; i<1000; i++){
+			long_postfix += " B +";
+		}
+		long_postfix_corpus.push_back(long_postfix);
+
+		cout << "Short expressions (ns/expression)" << endl;
+		cout << "Three parsers:\t" << nanoseconds_per_type_check(short_corpus, 20000, THREE_PARSERS) << endl;
+		cout << "Shared tokens:\t" << nanoseconds_per_type_check(short_corpus, 20000, SHARED_TOKENS) << endl;
+		cout << "Lex, classify:\t" << nanoseconds_per_type_check(short_corpus, 20000, LEX_AND_CLASSIFY) << endl;
+		cout << "With the tree:\t" << nanoseconds_per_type_check(short_corpus, 20000, FULL_EXPRESSION) << endl;
+
+		cout << "Postfix with 1000 operators (ns/expression)" << endl;
+		cout << "Three parsers:\t" << nanoseconds_per_type_check(long_postfix_corpus, 2000, THREE_PARSERS) << endl;
+		cout << "Shared tokens:\t" << nanoseconds_per_type_check(long_postfix_corpus, 2000, SHARED_TOKENS) << endl;
+		cout << "Lex, classify:\t" << nanoseconds_per_type_check(long_postfix_corpus, 2000, LEX_AND_CLASSIFY) << endl;
+		cout << "With the tree:\t" << nanoseconds_per_type_check(long_postfix_corpus, 2000, FULL_EXPRESSION) << endl;
 
 		return 0;
 	}
 
-	int get_equivalent_tester(){
-
-		for(int i=0; i<4; i++){
-			Expression test(infix_expressions.at(i));
-			test.get_equivalents();
+	//Two malformed copies of every test expression, one cut short and one with a stray '#', next to the expression
+	//itself, and a long infix expression missing its last parenthesis. Checks that the screen agrees with the
+	//grammars on all of them before timing it.
+	int error_corpus_benchmark(){
+
+		cout << "Benchmarking Malformed Input" << endl;
+
+		vector<string> error_corpus;
+		vector<string> long_error_corpus;
+		vector<string> expressions;
+		string long_infix = "(A";
+
+		expressions.insert(expressions.end(), infix_expressions.begin(), infix_expressions.end());
+		expressions.insert(expressions.end(), prefix_expressions.begin(), prefix_expressions.end());
+		expressions.insert(expressions.end(), postfix_expressions.begin(), postfix_expressions.end());
+		for(int i=0; i<(int) expressions.size(); i++){
+			string expression = expressions.at(i);
+			error_corpus.push_back(expression);
+			error_corpus.push_back(expression.substr(0, expression.length() - 1));
+			error_corpus.push_back(expression.substr(0, expression.length() / 2) + "#" + expression.substr(expression.length() / 2));
 		}
 
-		for(int i=4; i<8; i++){
-			Expression test(prefix_expressions.at(i));
-			test.get_equivalents();
+		for(int i=0; i<1000; i++){
+			long_infix += " + (B * C)";
 		}
+		long_error_corpus.push_back(long_infix);
 
-		for(int i=8; i<12; i++){
-			Expression test(postfix_expressions.at(i));
-			test.get_equivalents();
+		bool passed = true;
+		for(int i=0; i<(int) error_corpus.size(); i++){
+			if(Expression::classify(error_corpus.at(i)) != classify_unscreened(error_corpus.at(i))){
+				passed = false;
+			}
 		}
-	
+		if(Expression::classify(long_infix) != ERROR_EXPR){
+			passed = false;
+		}
+		cout << "Result:\t";
+		if(passed){
+			cout << "PASSED" << endl;
+		} else {
+			cout << "FAILED" << endl;
+		}
+
+		cout << "Short expressions, two thirds malformed (ns/expression)" << endl;
+		cout << "Grammars only:\t" << nanoseconds_per_classification(error_corpus, 20000, false) << endl;
+		cout << "Screen first:\t" << nanoseconds_per_classification(error_corpus, 20000, true) << endl;
+
+		cout << "Infix with 2000 operators and a missing parenthesis (ns/expression)" << endl;
+		cout << "Grammars only:\t" << nanoseconds_per_classification(long_error_corpus, 2000, false) << endl;
+		cout << "Screen first:\t" << nanoseconds_per_classification(long_error_corpus, 2000, true) << endl;
+
 		return 0;
 	}
 
-	int evaluator_tester(){
 
-		vector<string> expressions_to_test;
-		vector<string> expected_results;
+};
 
-		expressions_to_test.push_back("6 2 3 + - 3 8 2 / + * 2 ^ 3 +");
-		expressions_to_test.push_back("+ 9 * 2 6");
-		expressions_to_test.push_back("- + 7 * 4 5 + 2 0");
-		expressions_to_test.push_back("- + 8 / 6 3 2");
-		expressions_to_test.push_back("( 5 + 10 ) / ( 20 / 4 )");
 
-		expected_results.push_back("52");
-		expected_results.push_back("21");
-		expected_results.push_back("25");
-		expected_results.push_back("8");
-		expected_results.push_back("3");
+int main(int argc, char* argv[]){
 
-		for(int i=0; i<expressions_to_test.size(); i++){
-			cout << endl;
-			Expression expr(expressions_to_test.at(i));
-			expr.evaluate();
-			cout << "Expected: " << expected_results.at(i) << endl;
-			cout << endl;
+	//--batch [file] [--threads N] [--mmap] converts and evaluates every line of file, or of the standard input when no file is given.
+	//N threads share the work, 0 means one per core. --mmap maps the file instead of reading it. --generate size file
+	//writes size bytes of sample expressions.
+	if(argc >= 2 && string(argv[1]) == "--batch"){
+		string path = "";
+		int thread_count = 1;
+		bool mapped = false;
+		for(int i=2; i<argc; i++){
+			if(string(argv[i]) == "--threads" && i + 1 < argc){
+				thread_count = atoi(argv[i + 1]);
+				i++;
+			}
+			else if(string(argv[i]) == "--mmap"){
+				mapped = true;
+			} else {
+				path = argv[i];
+			}
+		}
+		if(thread_count <= 0){
+			thread_count = max(1, (int) thread::hardware_concurrency());
 		}
 
-		return 0;
+		ios::sync_with_stdio(false);
+		if(path != "" && mapped){
+			if(process_mapped_batch(path.c_str(), cout, 1 << 20, thread_count) != 0){
+				cout << "CANNOT MAP " << path << endl;
+				return 1;
+			}
+			return 0;
+		}
+		if(path != ""){
+			ifstream file(path.c_str(), ios::binary);
+			if(!file){
+				cout << "CANNOT OPEN " << path << endl;
+				return 1;
+			}
+			return process_batch(file, cout, 1 << 20, thread_count);
+		}
+		return process_batch(cin, cout, 1 << 20, thread_count);
 	}
 
+	//--stream [file] [--prefix] evaluates one postfix (or prefix) expression of any length, read in blocks from file or
+	//from the standard input
+	if(argc >= 2 && string(argv[1]) == "--stream"){
+		string path = "";
+		ExpressionType notation = POSTFIX;
+		for(int i=2; i<argc; i++){
+			if(string(argv[i]) == "--prefix"){
+				notation = PREFIX;
+			} else {
+				path = argv[i];
+			}
+		}
 
-};
-
+		if(path != ""){
+			ifstream file(path.c_str(), ios::binary);
+			if(!file){
+				cout << "CANNOT OPEN " << path << endl;
+				return 1;
+			}
+			return process_stream(file, cout, 1 << 20, notation);
+		}
+		return process_stream(cin, cout, 1 << 20, notation);
+	}
 
-int main(void){
+	//--to-postfix [file] converts one infix expression of any length, read in blocks from file or from the standard
+	//input, writing the postfix as it goes
+	if(argc >= 2 && string(argv[1]) == "--to-postfix"){
+		ios::sync_with_stdio(false);
+		if(argc >= 3){
+			ifstream file(argv[2], ios::binary);
+			if(!file){
+				cout << "CANNOT OPEN " << argv[2] << endl;
+				return 1;
+			}
+			return process_infix_stream(file, cout, 1 << 20);
+		}
+		return process_infix_stream(cin, cout, 1 << 20);
+	}
 
 	ExpressionsTester tester;
 
+	if(argc >= 4 && string(argv[1]) == "--generate"){
+		return tester.generate_batch_file(argv[3], atoll(argv[2]));
+	}
+
 	// tester.test_parser_and_converter();
 	// tester.get_equivalent_tester();
 	tester.evaluator_tester();
+	// tester.classifier_tester();
+	// tester.decimal_evaluator_tester();
+	// tester.integer_evaluator_tester();
+	// tester.streaming_evaluator_tester();
+	// tester.bound_evaluator_tester();
+	// tester.column_evaluator_tester();
+	// tester.parentheses_tester();
+	// tester.streaming_converter_tester();
+	// tester.streaming_classifier_tester();
+	// tester.batch_tester();
+	// tester.string_view_tester();
+	// tester.mask_lexer_tester();
+	// tester.batch_scaling_benchmark();
+	// tester.mapped_input_benchmark();
+	// tester.allocation_benchmark();
+	// tester.lexer_benchmark();
+	// tester.depth_limit_tester();
+	// tester.deep_expression_benchmark();
+	// tester.evaluate_type_benchmark();
+	// tester.error_corpus_benchmark();
+	// tester.postfix_conversion_benchmark();
+	// tester.infix_emission_benchmark();
+	// tester.skewed_conversion_benchmark();
+	// tester.streaming_conversion_benchmark();
+	// tester.arena_benchmark();
+	// tester.evaluate_benchmark();
+	// tester.direct_evaluation_benchmark();
+	// tester.streaming_evaluation_benchmark();
+	// tester.bound_evaluation_benchmark();
+	// tester.column_evaluation_benchmark();
+	// tester.integer_evaluation_benchmark();
 
 	// Expression test("( 5 + 10 ) / ( 20 / 4 )");
 	// test.get_equivalents();